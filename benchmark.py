@@ -1,5 +1,9 @@
 import numpy as np
+import os
 import sys
+import tempfile
+import threading
+import time
 import timeit
 
 sys.path.append('./build')
@@ -39,6 +43,13 @@ def run_benchmark():
     test_input_row = np.random.rand(1, 784).astype(np.float64)
     test_input_col = test_input_row.flatten() # The C++ predict method expects a 1D array
 
+    # Verify the single-sample paths against NumPy
+    expected = numpy_model.forward(test_input_row).flatten()
+    assert np.allclose(cpp_model.predict(test_input_col), expected), "predict mismatch"
+    logits = np.empty(10)
+    cpp_model.predict_into(test_input_col, logits)
+    assert np.allclose(logits, expected), "predict_into mismatch"
+
     def run_numpy():
         numpy_model.forward(test_input_row)
 
@@ -46,21 +57,320 @@ def run_benchmark():
     def run_cpp():
         cpp_model.predict(test_input_col)
 
+    def run_cpp_into():
+        cpp_model.predict_into(test_input_col, logits)
+
     num_runs = 2000
     print(f"\nRunning each implementation {num_runs} times...")
 
     time_numpy = timeit.timeit(run_numpy, number=num_runs)
     time_cpp = timeit.timeit(run_cpp, number=num_runs)
+    time_cpp_into = timeit.timeit(run_cpp_into, number=num_runs)
 
     avg_time_numpy_us = (time_numpy / num_runs) * 1_000_000
     avg_time_cpp_us = (time_cpp / num_runs) * 1_000_000
+    avg_time_cpp_into_us = (time_cpp_into / num_runs) * 1_000_000
     speedup = avg_time_numpy_us / avg_time_cpp_us
 
     print("\n--- Benchmark Results (Corrected) ---")
     print(f"NumPy Average Inference Time: {avg_time_numpy_us:.2f} µs (microseconds)")
     print(f"C++ Average Inference Time:   {avg_time_cpp_us:.2f} µs (microseconds)")
+    print(f"C++ predict_into Time:        {avg_time_cpp_into_us:.2f} µs (microseconds)")
     print(f"\nSpeedup Factor: {speedup:.2f}x")
     print("-------------------------------------")
 
+    run_profile_report(cpp_model, test_input_col)
+    run_batch_benchmark(numpy_model, cpp_model)
+    run_precision_benchmark(cpp_model, w1, b1, w2, b2)
+    run_sequential_check(numpy_model, w1, b1, w2, b2)
+    run_model_file_check(numpy_model, w1, b1, w2, b2)
+    run_server_load_test(cpp_model)
+
+def run_profile_report(cpp_model, test_input, num_runs=2000):
+    print("\n--- Per-stage latency (MLP.stats()) ---")
+    if not cpp_model.stats()["enabled"]:
+        print("Profiling is compiled out; configure with -DINFERENCE_PROFILING=ON to enable it.")
+        print("-------------------------------------")
+        return
+
+    cpp_model.reset_stats()
+    for _ in range(num_runs):
+        cpp_model.predict(test_input)
+    cpp_model.predict_batch(np.random.rand(1024, 784).astype(np.float32))
+    stats = cpp_model.stats()
+    print(f"{stats['calls']} calls, {stats['rows']} rows, "
+          f"{stats['bytes_in'] / 1e6:.1f} MB in, {stats['bytes_out'] / 1e6:.2f} MB out")
+    print(f"{'stage':<17} {'count':>7} {'mean_us':>9} {'p50_us':>9} {'p99_us':>9} {'max_us':>9}")
+    for name, stage in stats["stages"].items():
+        if stage["count"]:
+            print(f"{name:<17} {stage['count']:>7} {stage['mean_ns'] / 1e3:>9.2f} {stage['p50_ns'] / 1e3:>9.2f} "
+                  f"{stage['p99_ns'] / 1e3:>9.2f} {stage['max_ns'] / 1e3:>9.2f}")
+
+    # One count per library call; the batch is one call of 1024 rows.
+    stages = stats["stages"]
+    assert stats["calls"] == num_runs + 1, f"expected {num_runs + 1} calls, got {stats['calls']}"
+    assert stats["rows"] == num_runs + 1024, "row counter mismatch"
+    assert stages["total"]["count"] == stats["calls"], "total stage count differs from calls"
+    assert stages["output_copy"]["count"] == stats["calls"], "output_copy is not recorded once per call"
+    for name, stage in stages.items():
+        if stage["count"]:
+            assert stage["p50_ns"] <= stage["p90_ns"] <= stage["p99_ns"] <= stage["max_ns"], \
+                f"{name} percentiles out of order"
+
+    cpp_model.reset_stats()
+    cleared = cpp_model.stats()
+    assert all(cleared[key] == 0 for key in ("calls", "rows", "bytes_in", "bytes_out")), "reset_stats left counters"
+    assert all(stage["count"] == 0 for stage in cleared["stages"].values()), "reset_stats left samples"
+    print("Counters, stage counts and percentile order are consistent; reset_stats clears everything.")
+    print("-------------------------------------")
+
+def run_batch_benchmark(numpy_model, cpp_model):
+    print("\n--- Batched Inference: NumPy vs. C++/Eigen predict_batch ---")
+
+    batch_size = 10_000
+    batch = np.random.rand(batch_size, 784)
+
+    # Verify the batched path against NumPy before timing it
+    expected = numpy_model.forward(batch)
+    assert np.allclose(cpp_model.predict_batch(batch), expected), "predict_batch (float64) mismatch"
+    assert np.allclose(cpp_model.predict_batch(batch.astype(np.float32)), expected, atol=1e-4), "predict_batch (float32) mismatch"
+    out = np.empty((batch_size, 10))
+    cpp_model.predict_batch(batch, out)
+    assert np.allclose(out, expected), "predict_batch (out=) mismatch"
+
+    num_runs = 20
+    time_numpy = timeit.timeit(lambda: numpy_model.forward(batch), number=num_runs)
+    time_cpp = timeit.timeit(lambda: cpp_model.predict_batch(batch, out), number=num_runs)
+
+    per_sample_numpy_us = time_numpy / (num_runs * batch_size) * 1_000_000
+    per_sample_cpp_us = time_cpp / (num_runs * batch_size) * 1_000_000
+
+    print(f"Batch size: {batch_size}")
+    print(f"NumPy per-sample time: {per_sample_numpy_us:.3f} µs")
+    print(f"C++ per-sample time:   {per_sample_cpp_us:.3f} µs")
+    print(f"\nSpeedup Factor: {per_sample_numpy_us / per_sample_cpp_us:.2f}x")
+    print("-------------------------------------")
+
+def run_precision_benchmark(cpp_model, w1, b1, w2, b2):
+    print("\n--- Reduced Precision: float64 vs. float32 vs. int8 ---")
+    print(f"int8 kernel: {cpp_math.MLPInt8.kernel}")
+
+    models = {
+        "float64": cpp_model,
+        "float32": cpp_math.MLPFloat32(w1, b1, w2, b2),
+        "int8": cpp_math.MLPInt8(w1, b1, w2, b2),
+    }
+
+    batch_size = 10_000
+    batch = np.random.rand(batch_size, 784)
+    batch32 = batch.astype(np.float32)
+    reference = cpp_model.predict_batch(batch)
+    reference_labels = reference.argmax(axis=1)
+
+    num_runs = 20
+    for name, model in models.items():
+        model_input = batch if name == "float64" else batch32
+        logits = model.predict_batch(model_input)
+        max_error = np.abs(logits - reference).max()
+        agreement = (logits.argmax(axis=1) == reference_labels).mean() * 100
+        elapsed = timeit.timeit(lambda: model.predict_batch(model_input), number=num_runs)
+        per_sample_us = elapsed / (num_runs * batch_size) * 1_000_000
+        print(f"{name:>8}: {per_sample_us:.3f} µs/sample, max |error| {max_error:.2e}, "
+              f"argmax agreement {agreement:.2f}%")
+
+    assert np.allclose(models["float32"].predict_batch(batch32), reference, atol=1e-3), "float32 mismatch"
+
+    int8_logits = models["int8"].predict_batch(batch32)
+    bound = int8_error_bound(batch, w1, b1, w2)
+    assert np.all(np.abs(int8_logits - reference) <= bound), "int8 error exceeds the quantization bound"
+    agreement = (int8_logits.argmax(axis=1) == reference_labels).mean()
+    assert agreement >= 0.99, f"int8 argmax agreement {agreement:.2%} is below 99%"
+
+    # int32 accumulation is exact, so every SIMD kernel must match scalar bit for bit.
+    default_kernel = cpp_math.MLPInt8.kernel
+    kernels = cpp_math.MLPInt8.available_kernels()
+    results = {}
+    for kernel in kernels:
+        cpp_math.MLPInt8.set_kernel(kernel)
+        results[kernel] = models["int8"].predict_batch(batch32[:1000])
+    cpp_math.MLPInt8.set_kernel(default_kernel)
+    for kernel in kernels:
+        assert np.array_equal(results[kernel], results["scalar"]), f"int8 {kernel} kernel differs from scalar"
+    print(f"int8 within its quantization bound; kernels {', '.join(kernels)} match exactly.")
+    print("-------------------------------------")
+
+# Worst-case |logit error| of MLPInt8 against float64, per sample and output,
+# from its scales. Rounding to the nearest int8 step is off by at most half a
+# step in both the weights (per output channel) and the activations (per
+# sample, per layer). Layer 1's error passes through ReLU unchanged in size
+# and adds to the rounding of the hidden activations. The 1% and 1e-4 margins
+# cover float32 arithmetic.
+def int8_error_bound(x, w1, b1, w2):
+    w1_step = np.abs(w1).max(axis=0) / 127
+    w2_step = np.abs(w2).max(axis=0) / 127
+    x_step = np.abs(x).max(axis=1, keepdims=True) / 127
+
+    hidden = np.maximum(0, x @ w1 + b1)
+    hidden_error = np.abs(x).sum(axis=1, keepdims=True) * w1_step / 2 + x_step / 2 * (np.abs(w1) + w1_step / 2).sum(axis=0)
+    hidden_step = (hidden + hidden_error).max(axis=1, keepdims=True) / 127
+    input_error = hidden_error + hidden_step / 2
+
+    bound = hidden.sum(axis=1, keepdims=True) * w2_step / 2 + input_error @ (np.abs(w2) + w2_step / 2)
+    return bound * 1.01 + 1e-4
+
+def run_sequential_check(numpy_model, w1, b1, w2, b2):
+    print("\n--- Sequential and fixed-shape networks ---")
+
+    batch = np.random.rand(1_000, 784)
+    expected = numpy_model.forward(batch)
+
+    sequential = cpp_math.Sequential([(w1, b1), "relu", (w2, b2)])
+    print(sequential.describe(), end="")
+    assert np.allclose(sequential.predict_batch(batch), expected), "Sequential mismatch"
+    assert np.allclose(cpp_math.Sequential([w1, w2], [b1, b2]).predict(batch[0]), expected[0]), "Sequential predict mismatch"
+
+    fixed = cpp_math.FixedMLP784x128x10([w1, w2], [b1, b2])
+    assert np.allclose(fixed.predict_batch(batch.astype(np.float32)), expected, atol=1e-3), "FixedMLP784x128x10 mismatch"
+
+    # A deeper network with a softmax head must still produce distributions
+    w3 = np.random.randn(10, 10)
+    probs = cpp_math.Sequential([(w1, b1), "relu", (w2, b2), "tanh", (w3, np.zeros(10)), "softmax"]).predict_batch(batch)
+    assert np.allclose(probs.sum(axis=1), 1.0), "softmax rows must sum to 1"
+    print("Sequential, FixedMLP784x128x10 and softmax head match NumPy.")
+    print("-------------------------------------")
+
+def run_model_file_check(numpy_model, w1, b1, w2, b2):
+    print("\n--- Memory-mapped model files ---")
+
+    batch = np.random.rand(1_000, 784)
+    expected = numpy_model.forward(batch)
+
+    with tempfile.TemporaryDirectory() as tmp:
+        path = os.path.join(tmp, "mnist_mlp.cppm")
+        cpp_math.Sequential([(w1, b1), "relu", (w2, b2)]).save(path)
+        file_size = os.path.getsize(path)
+
+        num_runs = 200
+        load_time = timeit.timeit(lambda: cpp_math.load_model(path), number=num_runs)
+        load_time_unchecked = timeit.timeit(lambda: cpp_math.load_model(path, verify_checksum=False), number=num_runs)
+
+        model = cpp_math.load_model(path)
+        assert np.allclose(model.predict_batch(batch), expected), "mapped model mismatch"
+
+    print(f"Model file size: {file_size} bytes")
+    print(f"Load time (checksum verified): {load_time / num_runs * 1_000_000:.1f} µs")
+    print(f"Load time (no checksum):       {load_time_unchecked / num_runs * 1_000_000:.1f} µs")
+    print("-------------------------------------")
+
+def run_server_load_test(cpp_model, num_clients=16, requests_per_client=500):
+    print("\n--- InferenceServer load test ---")
+    print(f"{num_clients} client threads x {requests_per_client} requests, closed loop")
+
+    inputs = np.random.rand(256, 784)
+    expected = cpp_model.predict_batch(inputs)
+
+    print(f"{'max_batch':>9} {'delay_us':>8} {'req/s':>10} {'p50_us':>8} {'p99_us':>8} {'mean_batch':>10}")
+    for max_batch_size in (1, 16, 64):
+        for max_delay_us in (0, 100, 500):
+            server = cpp_math.InferenceServer(cpp_model, max_batch_size=max_batch_size, max_delay_us=max_delay_us)
+            latencies = [[] for _ in range(num_clients)]
+
+            def client(index):
+                for i in range(requests_per_client):
+                    row = (index * requests_per_client + i) % len(inputs)
+                    start = time.perf_counter()
+                    logits = server.submit(inputs[row]).result()
+                    latencies[index].append(time.perf_counter() - start)
+                    if i == 0:
+                        assert np.allclose(logits, expected[row]), "InferenceServer mismatch"
+
+            threads = [threading.Thread(target=client, args=(i,)) for i in range(num_clients)]
+            start = time.perf_counter()
+            for thread in threads:
+                thread.start()
+            for thread in threads:
+                thread.join()
+            elapsed = time.perf_counter() - start
+
+            stats = server.stats()
+            server.shutdown()
+            all_latencies = np.concatenate(latencies) * 1_000_000
+            p50, p99 = np.percentile(all_latencies, [50, 99])
+            throughput = num_clients * requests_per_client / elapsed
+            print(f"{max_batch_size:>9} {max_delay_us:>8} {throughput:>10.0f} {p50:>8.1f} {p99:>8.1f} "
+                  f"{stats['mean_batch_size']:>10.2f}")
+    print("-------------------------------------")
+
+def run_vector_kernel_check():
+    print("\n--- math_lib vector kernels ---")
+    vec = cpp_math.vec
+    kernels = vec.available_kernels()
+    default_kernel = vec.kernel_name()
+    print(f"Kernel sets: {', '.join(kernels)} (default: {default_kernel})")
+
+    def run_ops(a, b, c):
+        y = b.copy()
+        vec.axpy(0.75, a, y)
+        return [vec.add(a, b), vec.sub(a, b), vec.mul(a, b), vec.scale(a, -1.5), vec.fma(a, b, c), y,
+                vec.clamp(a, -0.5, 0.5), vec.standardize(a, 0.25, 4.0),
+                np.array([vec.sum(a), vec.dot(a, b), vec.norm(a)], dtype=a.dtype)]
+
+    # Every SIMD kernel set must match the scalar code bit for bit. Sizes cover
+    # empty arrays and every tail length; offsets make the views misaligned.
+    rng = np.random.default_rng(0)
+    sizes = list(range(0, 70)) + [255, 1_000, 4_099]
+    for dtype in (np.float64, np.float32):
+        for n in sizes:
+            for offset in (0, 1, 3):
+                a, b, c = (rng.standard_normal(n + offset).astype(dtype)[offset:] for _ in range(3))
+                if n > 2:
+                    a[1] = np.nan
+                vec.set_kernel("scalar")
+                expected = run_ops(a, b, c)
+                for kernel in kernels:
+                    vec.set_kernel(kernel)
+                    for op, (got, want) in enumerate(zip(run_ops(a, b, c), expected)):
+                        assert got.dtype == dtype and got.tobytes() == want.tobytes(), \
+                            f"{kernel} differs from scalar (op {op}, {np.dtype(dtype).name}, n={n}, offset={offset})"
+    vec.set_kernel(default_kernel)
+
+    # Elementwise ops round exactly like NumPy; reductions only differ by summation order.
+    a, b = rng.standard_normal(1_000), rng.standard_normal(1_000)
+    assert np.array_equal(vec.add(a, b), a + b) and np.array_equal(vec.mul(a, b), a * b), "elementwise mismatch"
+    assert np.array_equal(vec.clamp(a, -0.5, 0.5), np.clip(a, -0.5, 0.5)), "clamp mismatch"
+    assert np.isclose(vec.dot(a, b), np.dot(a, b)) and np.isclose(vec.norm(a), np.linalg.norm(a)), "reduction mismatch"
+
+    # Python int scalars must not push float32 arrays onto the float64 kernels.
+    x32 = rng.standard_normal(100).astype(np.float32)
+    for name, result in [("scale", vec.scale(x32, 2)), ("clamp", vec.clamp(x32, -1, 1)),
+                         ("standardize", vec.standardize(x32, 0, 2)), ("add", vec.add(x32, x32))]:
+        assert result.dtype == np.float32, f"vec.{name} returned {result.dtype} for float32 input"
+    y32 = x32.copy()
+    vec.axpy(2, x32, y32)
+    assert np.array_equal(y32, x32 + np.float32(2) * x32), "axpy with an int alpha mismatch"
+    assert vec.scale(a, 2).dtype == np.float64 and vec.scale(np.arange(5), 2).dtype == np.float64, "float64 fallback"
+    print(f"All kernel sets match the scalar path exactly ({len(sizes)} sizes x 3 offsets x 2 dtypes).")
+
+    num_runs = 200
+    x = rng.standard_normal(1_000_000).astype(np.float32)
+    y = rng.standard_normal(1_000_000).astype(np.float32)
+    out = np.empty_like(x)
+    timings = [
+        ("add (out=)", lambda: np.add(x, y, out=out), lambda: vec.add(x, y, out)),
+        ("axpy", lambda: np.add(out, 0.5 * x, out=out), lambda: vec.axpy(0.5, x, out)),
+        ("standardize", lambda: np.multiply(np.subtract(x, 0.25, out=out), 4.0, out=out),
+         lambda: vec.standardize(x, 0.25, 4.0, out)),
+        ("dot", lambda: np.dot(x, y), lambda: vec.dot(x, y)),
+    ]
+    print(f"float32, 1M elements, {num_runs} runs ({default_kernel})")
+    for name, numpy_fn, cpp_fn in timings:
+        numpy_time = timeit.timeit(numpy_fn, number=num_runs) / num_runs
+        cpp_time = timeit.timeit(cpp_fn, number=num_runs) / num_runs
+        print(f"{name:<12} NumPy {numpy_time * 1_000_000:8.1f} µs   C++ {cpp_time * 1_000_000:8.1f} µs   "
+              f"({numpy_time / cpp_time:.2f}x)")
+    print("-------------------------------------")
+
 if __name__ == "__main__":
+    # Needs no trained weights, so it runs before the weights file is loaded.
+    run_vector_kernel_check()
     run_benchmark()
\ No newline at end of file
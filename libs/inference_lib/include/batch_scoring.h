@@ -0,0 +1,59 @@
+#ifndef BATCH_SCORING_H
+#define BATCH_SCORING_H
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include "dataset.h"
+#include "sequential.h"
+
+// What score_dataset() writes for each row.
+//   Labels: the argmax of the logits as text, one per line.
+//   Logits: the raw logits, row-major in the network's dtype, no header.
+//   Csv:    the logits as comma-separated text, one row per line.
+enum class ScoreOutput { Labels, Logits, Csv };
+
+// Parses "labels", "logits" or "csv".
+ScoreOutput parse_score_output(const std::string& name);
+
+struct ScoringOptions {
+    // 0 means one worker per hardware thread.
+    std::size_t threads = 0;
+    // Rows per chunk; one chunk is one predict_batch() call.
+    Eigen::Index chunk_rows = 4096;
+    // Chunks that may be read, scored or waiting to be written at once.
+    // 0 means twice the number of workers. Together with chunk_rows this
+    // bounds memory use, independent of the dataset size.
+    std::size_t max_chunks_in_flight = 0;
+    ScoreOutput output = ScoreOutput::Labels;
+};
+
+struct ScoringStats {
+    Eigen::Index rows = 0;
+    std::size_t chunks = 0;
+    std::size_t threads = 0;
+    double seconds = 0.0;
+
+    double rows_per_second() const { return seconds > 0.0 ? double(rows) / seconds : 0.0; }
+};
+
+// Streams every row of `data` through `network` and writes the results to
+// `out` in row order. Worker threads each claim the next chunk, read it from
+// the mapping (in place when the file already holds the network's dtype),
+// run predict_batch and format the result; the calling thread writes the
+// finished chunks in order. Input pages are prefetched ahead of the workers
+// and released behind them.
+//
+// Throws std::invalid_argument if the dataset width does not match the
+// network, std::runtime_error if writing fails, and rethrows the first error
+// raised by a worker.
+template <typename Scalar>
+ScoringStats score_dataset(const BasicSequential<Scalar>& network, const MappedDataset& data, std::ostream& out,
+                           const ScoringOptions& options = {});
+
+extern template ScoringStats score_dataset<double>(const BasicSequential<double>&, const MappedDataset&,
+                                                   std::ostream&, const ScoringOptions&);
+extern template ScoringStats score_dataset<float>(const BasicSequential<float>&, const MappedDataset&,
+                                                  std::ostream&, const ScoringOptions&);
+
+#endif // BATCH_SCORING_H
@@ -0,0 +1,88 @@
+#ifndef DATASET_H
+#define DATASET_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <Eigen/Dense>
+#include "inference_lib.h"
+
+// Input formats understood by MappedDataset.
+//   Idx: the MNIST IDX format. A big-endian header (two zero bytes, a type
+//        code, the number of dimensions and one uint32 per dimension)
+//        followed by the values, big-endian. Dimension 0 is the row count;
+//        the remaining dimensions are flattened into columns.
+//   Raw: headerless row-major values in native byte order. The column count
+//        and element type are given by the caller.
+enum class DatasetFormat { Auto, Idx, Raw };
+
+enum class DatasetDType { UInt8, Int8, Int16, Int32, Float32, Float64 };
+
+// Parses "u8", "i8", "i16", "i32", "f32" or "f64".
+DatasetDType parse_dataset_dtype(const std::string& name);
+
+struct DatasetOptions {
+    // Auto picks Idx when the file starts with a valid IDX header whose shape
+    // matches the file size, and Raw otherwise.
+    DatasetFormat format = DatasetFormat::Auto;
+    DatasetDType raw_dtype = DatasetDType::Float32;
+    Eigen::Index raw_cols = 0;
+    // Every value is multiplied by `scale` when it is read.
+    double scale = 1.0;
+};
+
+// A feature matrix mapped read-only into memory, for datasets larger than
+// RAM. Rows are converted on demand; nothing is loaded up front. Callers
+// stream through it with prefetch() ahead of the rows they are about to read
+// and release() behind them, so only the rows in flight stay resident.
+// Rows may be read from several threads at once.
+class MappedDataset {
+public:
+    // Throws std::runtime_error if the file cannot be mapped or does not
+    // hold a whole number of rows, and std::invalid_argument for a raw file
+    // without a column count.
+    explicit MappedDataset(const std::string& path, const DatasetOptions& options = {});
+
+    Eigen::Index rows() const { return m_rows; }
+    Eigen::Index cols() const { return m_cols; }
+    DatasetFormat format() const { return m_format; }
+    DatasetDType dtype() const { return m_dtype; }
+
+    // Converts rows [first, first + out.rows()) into `out`, which must have
+    // cols() columns.
+    template <typename Scalar>
+    void read_rows(Eigen::Index first, Eigen::Ref<RowMatrix<Scalar>> out) const;
+
+    // The rows starting at `first` in place, if the file stores them exactly
+    // as Scalar (native byte order, scale 1); nullptr otherwise.
+    template <typename Scalar>
+    const Scalar* native_rows(Eigen::Index first) const;
+
+    // Asks the kernel to start reading the given rows in the background.
+    void prefetch(Eigen::Index first, Eigen::Index count) const;
+    // Drops the given rows from this process's resident memory. They are read
+    // again from the page cache or disk if touched later.
+    void release(Eigen::Index first, Eigen::Index count) const;
+
+private:
+    const unsigned char* row_bytes(Eigen::Index row) const;
+    void advise(Eigen::Index first, Eigen::Index count, int advice) const;
+
+    std::shared_ptr<const void> m_data;
+    std::size_t m_size = 0;
+    std::size_t m_data_offset = 0;
+    std::size_t m_element_size = 0;
+    DatasetFormat m_format = DatasetFormat::Raw;
+    DatasetDType m_dtype = DatasetDType::Float32;
+    bool m_big_endian = false;
+    double m_scale = 1.0;
+    Eigen::Index m_rows = 0;
+    Eigen::Index m_cols = 0;
+};
+
+extern template void MappedDataset::read_rows<double>(Eigen::Index, Eigen::Ref<RowMatrix<double>>) const;
+extern template void MappedDataset::read_rows<float>(Eigen::Index, Eigen::Ref<RowMatrix<float>>) const;
+extern template const double* MappedDataset::native_rows<double>(Eigen::Index) const;
+extern template const float* MappedDataset::native_rows<float>(Eigen::Index) const;
+
+#endif // DATASET_H
@@ -0,0 +1,157 @@
+#ifndef FIXED_SEQUENTIAL_H
+#define FIXED_SEQUENTIAL_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "inference_lib.h"
+
+// Dense network whose layer widths are template parameters, e.g.
+// FixedSequential<float, 784, 128, 10> is 784 -> 128 -> 10 with ReLU after
+// every hidden layer. Because every product has compile-time dimensions,
+// Eigen can fully unroll and vectorize the small layers and the activation
+// vectors live on the stack, so predict never touches the heap.
+//
+// Weights are still stored on the heap: Eigen refuses fixed-size objects
+// larger than EIGEN_STACK_ALLOCATION_LIMIT, so each layer is kept in an
+// aligned dynamic matrix and viewed through a fixed-size Map.
+template <typename Scalar, int... Dims>
+class FixedSequential {
+    static_assert(sizeof...(Dims) >= 2, "A network needs at least an input and an output width.");
+
+public:
+    static constexpr std::size_t kLayers = sizeof...(Dims) - 1;
+    static constexpr int kDims[] = {Dims...};
+    static constexpr int kInputs = kDims[0];
+    static constexpr int kOutputs = kDims[kLayers];
+
+    using Matrix = Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic>;
+    using Vector = Eigen::Matrix<Scalar, Eigen::Dynamic, 1>;
+    using Input = Eigen::Matrix<Scalar, kInputs, 1>;
+    using Output = Eigen::Matrix<Scalar, kOutputs, 1>;
+    using BatchMatrix = RowMatrix<Scalar>;
+
+    // predict_batch pushes this many rows through all layers at once, as
+    // BasicMLP does.
+    static constexpr Eigen::Index kBatchTileRows = BasicMLP<Scalar>::kBatchTileRows;
+
+    FixedSequential(const std::vector<Matrix>& weights, const std::vector<Vector>& biases) {
+        if (weights.size() != kLayers || biases.size() != kLayers) {
+            throw std::invalid_argument("Expected " + std::to_string(kLayers) + " weight matrices and bias vectors.");
+        }
+        for (std::size_t l = 0; l < kLayers; ++l) {
+            if (weights[l].rows() != kDims[l] || weights[l].cols() != kDims[l + 1] || biases[l].size() != kDims[l + 1]) {
+                throw std::invalid_argument("Layer " + std::to_string(l) + " must be " + std::to_string(kDims[l]) +
+                                            " x " + std::to_string(kDims[l + 1]) + ".");
+            }
+            m_weights[l] = weights[l];
+            m_biases[l] = biases[l];
+        }
+    }
+
+    Output predict(const Input& input) const {
+        Output output;
+        forward<0>(input.transpose(), output);
+        return output;
+    }
+
+    // One sample per row, like BasicMLP::predict_batch. Each tile of rows is
+    // viewed as a matrix with a compile-time column count, so every layer
+    // runs as one GEMM per tile with fixed inner dimensions.
+    void predict_batch(const Eigen::Ref<const BatchMatrix>& input, Eigen::Ref<BatchMatrix> output) const {
+        if (input.cols() != kInputs || output.rows() != input.rows() || output.cols() != kOutputs) {
+            throw std::invalid_argument("Expected an N x " + std::to_string(kInputs) + " input and an N x " +
+                                        std::to_string(kOutputs) + " output.");
+        }
+        // Consecutive layers' activations for one tile alternate between the
+        // two buffers, which are allocated once per call.
+        const Eigen::Index tile_rows = std::min(input.rows(), kBatchTileRows);
+        Vector buffers[2] = {Vector(tile_rows * kMaxHidden), Vector(tile_rows * kMaxHidden)};
+        for (Eigen::Index start = 0; start < input.rows(); start += kBatchTileRows) {
+            const Eigen::Index n = std::min(kBatchTileRows, input.rows() - start);
+            const TileMap<const Scalar, kInputs> x(input.row(start).data(), n, kInputs,
+                                                   Eigen::OuterStride<>(input.outerStride()));
+            TileMap<Scalar, kOutputs> out(output.row(start).data(), n, kOutputs,
+                                          Eigen::OuterStride<>(output.outerStride()));
+            forward_tile<0>(x, out, buffers);
+        }
+    }
+
+    BatchMatrix predict_batch(const Eigen::Ref<const BatchMatrix>& input) const {
+        BatchMatrix output(input.rows(), kOutputs);
+        predict_batch(input, output);
+        return output;
+    }
+
+private:
+    static constexpr int max_hidden() {
+        int widest = 0;
+        for (std::size_t l = 1; l < kLayers; ++l) {
+            widest = std::max(widest, kDims[l]);
+        }
+        return widest;
+    }
+    static constexpr int kMaxHidden = max_hidden();
+
+    // A tile of samples, one per row, with a compile-time number of columns.
+    template <typename T, int Cols>
+    using TileMatrix = Eigen::Matrix<std::remove_const_t<T>, Eigen::Dynamic, Cols,
+                                     Cols == 1 ? Eigen::ColMajor : Eigen::RowMajor>;
+    template <typename T, int Cols>
+    using TileMap = Eigen::Map<std::conditional_t<std::is_const_v<T>, const TileMatrix<T, Cols>, TileMatrix<T, Cols>>,
+                               Eigen::Unaligned, Eigen::OuterStride<>>;
+
+    // Applies layer L to the tile `x`, one GEMM with the bias preloaded, and
+    // recurses into the next layer. Hidden activations go into buffers[L % 2].
+    // The tiles keep their compile-time widths, but the weights are used
+    // through the dynamic matrix: Eigen's GEMM kernel takes runtime sizes
+    // anyway. A fixed-size view would only be propagated into Eigen's
+    // one-row GEMV fallback, where GCC then warns about loops that never run.
+    template <std::size_t L, typename Tile, typename OutTile>
+    void forward_tile(const Tile& x, OutTile& output, Vector* buffers) const {
+        constexpr int Out = kDims[L + 1];
+        const Matrix& w = m_weights[L];
+        const Eigen::Map<const Eigen::Matrix<Scalar, 1, Out>, Eigen::AlignedMax> b(m_biases[L].data());
+
+        if constexpr (L + 1 < kLayers) {
+            TileMap<Scalar, Out> z(buffers[L % 2].data(), x.rows(), Out, Eigen::OuterStride<>(Out));
+            z.rowwise() = b;
+            z.noalias() += x * w;
+            z = z.cwiseMax(Scalar(0));
+            forward_tile<L + 1>(z, output, buffers);
+        } else {
+            output.rowwise() = b;
+            output.noalias() += x * w;
+        }
+    }
+
+    // Applies layer L to the row vector `x` and recurses into the next layer.
+    template <std::size_t L, typename Row>
+    void forward(const Row& x, Output& output) const {
+        constexpr int In = kDims[L];
+        constexpr int Out = kDims[L + 1];
+        const Eigen::Map<const Eigen::Matrix<Scalar, In, Out>, Eigen::AlignedMax> w(m_weights[L].data());
+        const Eigen::Map<const Eigen::Matrix<Scalar, 1, Out>, Eigen::AlignedMax> b(m_biases[L].data());
+
+        Eigen::Matrix<Scalar, 1, Out> z;
+        z.noalias() = x * w;
+        z += b;
+        if constexpr (L + 1 < kLayers) {
+            forward<L + 1>(z.cwiseMax(Scalar(0)).eval(), output);
+        } else {
+            output = z.transpose();
+        }
+    }
+
+    std::array<Matrix, kLayers> m_weights;
+    std::array<Vector, kLayers> m_biases;
+};
+
+// The 784 -> 128 -> 10 MNIST model in float32.
+using FixedMnistMLP = FixedSequential<float, 784, 128, 10>;
+
+#endif // FIXED_SEQUENTIAL_H
\ No newline at end of file
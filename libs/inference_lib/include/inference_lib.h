@@ -2,22 +2,97 @@
 #define INFERENCE_LIB_H
 
 #include <Eigen/Dense>
+#include "profiling.h"
 
-class MLP {
+// Row-major matrices share the memory layout of C-contiguous NumPy arrays,
+// so a batch of samples (one per row) can be passed in without copying.
+template <typename Scalar>
+using RowMatrix = Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+using RowMatrixXd = RowMatrix<double>;
+using RowMatrixXf = RowMatrix<float>;
+
+// Two-layer perceptron (dense -> ReLU -> dense) with weights stored as
+// `Scalar`. Use the MLP (float64) and MLPf (float32) aliases below; the
+// float32 variant halves the weight bandwidth of every forward pass.
+template <typename Scalar>
+class BasicMLP {
 public:
+    using Matrix = Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic>;
+    using Vector = Eigen::Matrix<Scalar, Eigen::Dynamic, 1>;
+    using BatchMatrix = RowMatrix<Scalar>;
+
+    // Number of samples pushed through the network at once by predict_batch.
+    // Large batches are split into tiles of this many rows so the hidden
+    // activations stay in cache between the two layers.
+    static constexpr Eigen::Index kBatchTileRows = 128;
+
+    // Scratch buffers for the allocation-free predict_into path. Each thread
+    // that shares an MLP should own one, created with make_workspace().
+    struct Workspace {
+        Vector hidden;
+    };
+
     // Constructor
-    MLP(const Eigen::MatrixXd& w1, const Eigen::VectorXd& b1,
-        const Eigen::MatrixXd& w2, const Eigen::VectorXd& b2);
+    BasicMLP(const Matrix& w1, const Vector& b1,
+             const Matrix& w2, const Vector& b2);
+
+    // The predict method that will be called from Python. Thread-safe: the
+    // forward pass runs in a workspace owned by the calling thread.
+    Vector predict(const Eigen::Ref<const Vector>& input) const;
+
+    // Single-sample forward pass that performs no heap allocations: results go
+    // into the caller's `output` (output_size() elements). The first overload
+    // uses the workspace owned by this MLP, so it must not be called from
+    // several threads at once; the second is const and thread-safe as long as
+    // every thread passes its own workspace.
+    void predict_into(const Eigen::Ref<const Vector>& input, Eigen::Ref<Vector> output);
+    void predict_into(const Eigen::Ref<const Vector>& input, Eigen::Ref<Vector> output,
+                      Workspace& workspace) const;
+    Workspace make_workspace() const;
+
+    // Batched forward pass: `input` is N x input_size(), one sample per row,
+    // and `output` must be N x output_size(). Each layer runs as one
+    // matrix-matrix product per tile. Input of the other precision is
+    // converted tile by tile.
+    void predict_batch(const Eigen::Ref<const RowMatrixXd>& input, Eigen::Ref<BatchMatrix> output) const;
+    void predict_batch(const Eigen::Ref<const RowMatrixXf>& input, Eigen::Ref<BatchMatrix> output) const;
+    BatchMatrix predict_batch(const Eigen::Ref<const BatchMatrix>& input) const;
 
-    // The predict method that will be called from Python
-    Eigen::VectorXd predict(const Eigen::VectorXd& input);
+    Eigen::Index input_size() const { return m_w1.rows(); }
+    Eigen::Index output_size() const { return m_w2.cols(); }
+
+    // Latency histograms and counters of every call on this MLP, per stage
+    // (see profiling.h). Without INFERENCE_PROFILING nothing is recorded and
+    // stats() returns an empty ProfileStats with enabled == false.
+    ProfileStats stats() const;
+    void reset_stats();
+#ifdef INFERENCE_PROFILING
+    Profiler& profiler() const { return m_profiler; }
+#endif
 
 private:
+    template <typename InputMatrix>
+    void run_batch(const InputMatrix& input, Eigen::Ref<BatchMatrix> output) const;
+
     // Member variables to store the weights and biases
-    Eigen::MatrixXd m_w1;
-    Eigen::VectorXd m_b1;
-    Eigen::MatrixXd m_w2;
-    Eigen::VectorXd m_b2;
+    Matrix m_w1;
+    Vector m_b1;
+    Matrix m_w2;
+    Vector m_b2;
+
+    // Workspace used by the non-const predict_into, sized at construction.
+    Workspace m_workspace;
+
+#ifdef INFERENCE_PROFILING
+    mutable Profiler m_profiler;
+#endif
 };
 
+// Both precisions are compiled once in inference_lib.cpp.
+extern template class BasicMLP<double>;
+extern template class BasicMLP<float>;
+
+using MLP = BasicMLP<double>;
+using MLPf = BasicMLP<float>;
+
 #endif // INFERENCE_LIB_H
\ No newline at end of file
@@ -0,0 +1,98 @@
+#ifndef INFERENCE_SERVER_H
+#define INFERENCE_SERVER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "inference_lib.h"
+#include "mpmc_queue.h"
+
+struct InferenceServerOptions {
+    // 0 means one worker per hardware thread.
+    std::size_t worker_threads = 0;
+    // Upper bound on the number of requests coalesced into one batch.
+    Eigen::Index max_batch_size = 64;
+    // How long a worker holding a partial batch waits for more requests,
+    // measured from the arrival of the oldest request in the batch.
+    std::chrono::microseconds max_delay{200};
+    // Capacity of the submission queue. submit() sleeps while it is full.
+    std::size_t queue_capacity = 4096;
+    // How long submit() waits for room in a full queue before giving up.
+    std::chrono::milliseconds submit_timeout{1000};
+};
+
+struct InferenceServerStats {
+    std::uint64_t requests = 0;
+    std::uint64_t batches = 0;
+};
+
+// In-process inference server for an MLP. Callers on any thread submit
+// single samples and get a future back. Requests go through a lock-free
+// queue to a pool of workers. One worker at a time collects a batch: it takes
+// the oldest request and keeps collecting more until the batch is full or the
+// oldest request's deadline has passed, sleeping while the queue is empty.
+// It then hands collection to the next worker, runs the whole batch through
+// MLP::predict_batch, and fulfils the futures.
+class InferenceServer {
+public:
+    InferenceServer(const MLP& model, InferenceServerOptions options = {});
+    ~InferenceServer();
+
+    InferenceServer(const InferenceServer&) = delete;
+    InferenceServer& operator=(const InferenceServer&) = delete;
+
+    // Queues `input`. Throws std::invalid_argument on a size mismatch, and
+    // std::runtime_error after shutdown() or if the queue stays full for
+    // options().submit_timeout.
+    std::future<Eigen::VectorXd> submit(Eigen::VectorXd input);
+
+    // Stops accepting requests, finishes everything already queued and joins
+    // the workers. Called by the destructor.
+    void shutdown();
+
+    InferenceServerStats stats() const;
+    const InferenceServerOptions& options() const { return m_options; }
+
+private:
+    struct Request {
+        Eigen::VectorXd input;
+        std::promise<Eigen::VectorXd> result;
+        std::chrono::steady_clock::time_point enqueued;
+    };
+
+    void worker_loop();
+    bool collect_batch(std::vector<Request*>& batch);
+    bool wait_for_work();
+    void wait_for_request(std::chrono::steady_clock::time_point deadline);
+    void push_blocking(Request* request);
+    void run_batch(std::vector<Request*>& batch, RowMatrixXd& inputs, RowMatrixXd& outputs);
+
+    const MLP m_model;
+    InferenceServerOptions m_options;
+    MpmcQueue<Request*> m_queue;
+
+    // Requests pushed but not yet popped, used to decide when workers may sleep.
+    std::atomic<std::size_t> m_pending{0};
+    std::atomic<std::size_t> m_sleeping{0};
+    std::atomic<std::size_t> m_blocked_submitters{0};
+    std::atomic<bool> m_stopping{false};
+    std::mutex m_wake_mutex;
+    // Workers wait on m_wake for requests, submitters on m_space for room.
+    std::condition_variable m_wake;
+    std::condition_variable m_space;
+    // Held by the worker that is collecting the next batch.
+    std::mutex m_fill_mutex;
+
+    std::atomic<std::uint64_t> m_requests{0};
+    std::atomic<std::uint64_t> m_batches{0};
+
+    std::vector<std::thread> m_workers;
+};
+
+#endif // INFERENCE_SERVER_H
\ No newline at end of file
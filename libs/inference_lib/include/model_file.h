@@ -0,0 +1,89 @@
+#ifndef MODEL_FILE_H
+#define MODEL_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "sequential.h"
+
+// On-disk model format (version 1), native little-endian byte order:
+//
+//   ModelFileHeader                      64 bytes
+//   ModelFileLayer[layer_count]          40 bytes each
+//   tensors                              each aligned to kModelFileAlignment
+//
+// Layers are the steps of a compiled Sequential plan, so a dense layer keeps
+// its fused activation. Weights are stored column-major (inputs x outputs),
+// exactly as Eigen holds them, so a mapped file can be used in place. The
+// checksum is FNV-1a over everything after the header.
+constexpr char kModelFileMagic[8] = {'C', 'P', 'P', 'M', 'O', 'D', 'E', 'L'};
+constexpr std::uint32_t kModelFileVersion = 1;
+constexpr std::uint32_t kModelFileByteOrderMark = 0x01020304;
+constexpr std::size_t kModelFileAlignment = 64;
+
+enum class ModelDType : std::uint32_t { Float32 = 1, Float64 = 2 };
+
+struct ModelFileHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byte_order;
+    std::uint32_t dtype;
+    std::uint32_t layer_count;
+    std::uint64_t file_size;
+    std::uint64_t checksum;
+    std::uint8_t reserved[24];
+};
+static_assert(sizeof(ModelFileHeader) == 64, "ModelFileHeader must stay 64 bytes.");
+
+struct ModelFileLayer {
+    std::uint32_t kind;        // LayerKind
+    std::uint32_t activation;  // Activation
+    std::uint64_t inputs;
+    std::uint64_t outputs;
+    std::uint64_t weights_offset;  // from the start of the file, 0 if none
+    std::uint64_t biases_offset;
+};
+static_assert(sizeof(ModelFileLayer) == 40, "ModelFileLayer must stay 40 bytes.");
+
+// Writes the execution plan of `network` to `path`, atomically replacing
+// any existing file: readers see either the old model or the complete new
+// one, even while other processes save to the same path. Throws
+// std::runtime_error on I/O errors, leaving no temporary file behind.
+template <typename Scalar>
+void save_model(const std::string& path, const BasicSequential<Scalar>& network);
+
+// A model file mapped read-only into memory. Networks returned by network()
+// point straight into the mapping, so loading costs one mmap() and processes
+// that map the same file share a single page-cached copy of the weights.
+// The mapping stays alive as long as this object or any such network does.
+class MappedModel {
+public:
+    // Throws std::runtime_error if the file cannot be mapped or is not a
+    // valid model. Checksum verification reads every page of the file; pass
+    // false to skip it when the file is trusted and startup time matters.
+    explicit MappedModel(const std::string& path, bool verify_checksum = true);
+
+    ModelDType dtype() const { return static_cast<ModelDType>(header().dtype); }
+    std::size_t size_bytes() const { return m_size; }
+    std::size_t layer_count() const { return header().layer_count; }
+
+    // Throws std::invalid_argument if Scalar does not match dtype().
+    template <typename Scalar>
+    BasicSequential<Scalar> network() const;
+
+private:
+    const ModelFileHeader& header() const { return *static_cast<const ModelFileHeader*>(m_data.get()); }
+    const ModelFileLayer* layers() const;
+
+    std::shared_ptr<const void> m_data;
+    std::size_t m_size = 0;
+};
+
+extern template void save_model<double>(const std::string&, const BasicSequential<double>&);
+extern template void save_model<float>(const std::string&, const BasicSequential<float>&);
+extern template BasicSequential<double> MappedModel::network<double>() const;
+extern template BasicSequential<float> MappedModel::network<float>() const;
+
+#endif // MODEL_FILE_H
\ No newline at end of file
@@ -0,0 +1,133 @@
+#ifndef PROFILING_H
+#define PROFILING_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Opt-in latency instrumentation for inference_lib, enabled by configuring
+// with -DINFERENCE_PROFILING=ON. Without it the macros below expand to nothing
+// and models carry no Profiler, so the hot paths compile exactly as if they
+// were not instrumented.
+
+// Stages of one inference call. Batched calls record the compute stages once
+// per tile.
+enum class ProfileStage : std::size_t {
+    Total,           // the whole library call
+    InputConversion, // converting input to the model's dtype (single samples: by the bindings)
+    Layer1,          // first dense layer: bias + GEMV/GEMM
+    Activation,      // hidden ReLU
+    Layer2,          // second dense layer: bias + GEMV/GEMM
+    OutputCopy,      // handing the result to Python (recorded by the bindings)
+    Count
+};
+
+constexpr std::size_t kProfileStageCount = static_cast<std::size_t>(ProfileStage::Count);
+
+const char* profile_stage_name(ProfileStage stage);
+
+struct ProfileStageStats {
+    std::string name;
+    std::uint64_t count = 0;
+    double total_ns = 0;
+    double mean_ns = 0;
+    // Percentiles are estimated from log buckets: within 12.5% of the true value.
+    double p50_ns = 0;
+    double p90_ns = 0;
+    double p99_ns = 0;
+    double max_ns = 0;
+};
+
+struct ProfileStats {
+    bool enabled = false;
+    std::uint64_t calls = 0;
+    std::uint64_t rows = 0;
+    std::uint64_t bytes_in = 0;
+    std::uint64_t bytes_out = 0;
+    std::vector<ProfileStageStats> stages;
+};
+
+// Histograms and counters for one model. Recording is lock-free: each thread
+// writes to one of kShards cache-line-aligned shards with relaxed atomics, so
+// threads sharing a model rarely touch the same line. stats() merges the
+// shards. Copies (and moves) start with empty statistics.
+//
+// A shard is allocated the first time a thread records into it and holds
+// every stage's histogram, about 15 KB. A model costs nothing until its first
+// call, about 15 KB per recording thread after that, and at most
+// kShards x 15 KB (about 120 KB) however many threads share it.
+class Profiler {
+public:
+    // Values are bucketed by their top three significant bits: eight buckets
+    // per power of two, exact below 8 ns, saturating at 2^40 ns (~18 min).
+    static constexpr std::size_t kSubBucketBits = 3;
+    static constexpr std::size_t kMaxBits = 40;
+    static constexpr std::size_t kBuckets = (kMaxBits - kSubBucketBits + 1) << kSubBucketBits;
+    static constexpr std::size_t kShards = 8;
+
+    Profiler() = default;
+    Profiler(const Profiler&);
+    Profiler& operator=(const Profiler&);
+    ~Profiler();
+
+    void record(ProfileStage stage, std::uint64_t ns);
+    void count(std::uint64_t rows, std::uint64_t bytes_in, std::uint64_t bytes_out);
+
+    ProfileStats stats() const;
+    void reset();
+
+    static std::size_t bucket_of(std::uint64_t ns);
+    // Smallest value that falls into `bucket`.
+    static std::uint64_t bucket_floor(std::size_t bucket);
+
+private:
+    struct Shard;
+    // The calling thread's shard, allocated on first use.
+    Shard& shard();
+
+    std::atomic<Shard*> m_shards[kShards] = {};
+};
+
+// Records the time from construction to destruction as one sample of `stage`.
+class ProfileScope {
+public:
+    ProfileScope(Profiler& profiler, ProfileStage stage)
+        : m_profiler(profiler), m_stage(stage), m_start(std::chrono::steady_clock::now()) {}
+    ~ProfileScope() {
+        const auto elapsed = std::chrono::steady_clock::now() - m_start;
+        m_profiler.record(m_stage, static_cast<std::uint64_t>(
+                                       std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+    }
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    Profiler& m_profiler;
+    ProfileStage m_stage;
+    std::chrono::steady_clock::time_point m_start;
+};
+
+#ifdef INFERENCE_PROFILING
+
+#define INFERENCE_PROFILE_CONCAT_INNER(a, b) a##b
+#define INFERENCE_PROFILE_CONCAT(a, b) INFERENCE_PROFILE_CONCAT_INNER(a, b)
+// Times the rest of the enclosing block as `stage`.
+#define INFERENCE_PROFILE_SCOPE(profiler, stage) \
+    ::ProfileScope INFERENCE_PROFILE_CONCAT(profile_scope_, __LINE__)((profiler), (stage))
+// Counts one call that processed `rows` rows, reading and writing the given bytes.
+#define INFERENCE_PROFILE_COUNT(profiler, rows, bytes_in, bytes_out) \
+    (profiler).count((rows), (bytes_in), (bytes_out))
+
+#else
+
+// The arguments are not evaluated, so they may name members that only exist
+// in profiling builds.
+#define INFERENCE_PROFILE_SCOPE(profiler, stage) static_cast<void>(0)
+#define INFERENCE_PROFILE_COUNT(profiler, rows, bytes_in, bytes_out) static_cast<void>(0)
+
+#endif // INFERENCE_PROFILING
+
+#endif // PROFILING_H
@@ -0,0 +1,77 @@
+#ifndef QUANTIZED_MLP_H
+#define QUANTIZED_MLP_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "inference_lib.h"
+
+// int8 variant of the two-layer MLP. Weights are quantized symmetrically per
+// output channel when the model is built, activations are quantized per
+// sample on the fly, and every dot product accumulates in int32 before being
+// rescaled to float. The weights take an eighth of the float64 footprint.
+class QuantizedMLP {
+public:
+    QuantizedMLP(const Eigen::MatrixXd& w1, const Eigen::VectorXd& b1,
+                 const Eigen::MatrixXd& w2, const Eigen::VectorXd& b2);
+
+    Eigen::VectorXf predict(const Eigen::Ref<const Eigen::VectorXf>& input) const;
+
+    // Same contract as BasicMLP::predict_batch: one sample per row. Rows run
+    // kRowBlock at a time and share each weight load, and every row's result
+    // is bit-identical to predict() on that row.
+    void predict_batch(const Eigen::Ref<const RowMatrixXf>& input, Eigen::Ref<RowMatrixXf> output) const;
+    RowMatrixXf predict_batch(const Eigen::Ref<const RowMatrixXf>& input) const;
+
+    Eigen::Index input_size() const { return m_layer1.inputs; }
+    Eigen::Index output_size() const { return m_layer2.outputs; }
+
+    // Name of the int8 dot-product kernel selected for this CPU at runtime:
+    // "avx512bw", "avx2" or "scalar".
+    static const char* kernel_name();
+
+    // Kernels this CPU can run, widest first. "scalar" is always last.
+    static std::vector<std::string> available_kernels();
+
+    // Switches every QuantizedMLP to the named kernel, e.g. to compare a SIMD
+    // kernel against "scalar". Integer accumulation is exact, so all kernels
+    // give identical results. Throws std::invalid_argument for an unavailable
+    // kernel.
+    static void set_kernel(const std::string& name);
+
+    // Samples that share each weight-row load in predict_batch.
+    static constexpr int kRowBlock = 8;
+
+private:
+    // One dense layer. Row j of `weights` holds output channel j, padded with
+    // zeros to `stride` so the SIMD kernels never need a tail loop.
+    struct Layer {
+        Eigen::Index inputs = 0;
+        Eigen::Index outputs = 0;
+        Eigen::Index stride = 0;
+        std::vector<std::int8_t> weights;
+        Eigen::VectorXf scales;
+        Eigen::VectorXf biases;
+    };
+
+    // Scratch for kRowBlock samples: the quantized activations feeding each
+    // layer (int8 values, kept widened to int16) and the float hidden
+    // activations between them, one row per sample.
+    struct Scratch {
+        std::vector<std::int16_t> input;
+        std::vector<std::int16_t> hidden_q;
+        Eigen::VectorXf hidden;
+    };
+
+    static Layer quantize_layer(const Eigen::MatrixXd& w, const Eigen::VectorXd& b);
+    Scratch make_scratch() const;
+    Scratch& thread_scratch() const;
+    template <int Rows>
+    void forward(const float* input, Eigen::Index input_stride, float* output, Eigen::Index output_stride,
+                 Scratch& scratch) const;
+
+    Layer m_layer1;
+    Layer m_layer2;
+};
+
+#endif // QUANTIZED_MLP_H
\ No newline at end of file
@@ -0,0 +1,138 @@
+#ifndef SEQUENTIAL_H
+#define SEQUENTIAL_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "inference_lib.h"
+
+// Elementwise (or, for Softmax, row-wise) functions applied after a layer.
+enum class Activation { Identity, ReLU, Tanh, Sigmoid, Softmax };
+
+// Parses "identity"/"none", "relu", "tanh", "sigmoid" or "softmax".
+Activation parse_activation(const std::string& name);
+const char* activation_name(Activation activation);
+
+enum class LayerKind { Dense, Activation };
+
+// One entry of a Sequential network: either a dense layer (weights are
+// inputs x outputs, like MLP) or a standalone activation.
+template <typename Scalar>
+struct BasicLayer {
+    using Matrix = Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic>;
+    using Vector = Eigen::Matrix<Scalar, Eigen::Dynamic, 1>;
+    using Kind = LayerKind;
+
+    Kind kind = Kind::Activation;
+    ::Activation activation = ::Activation::Identity;
+    Matrix weights;
+    Vector biases;
+
+    static BasicLayer dense(const Matrix& weights, const Vector& biases);
+    static BasicLayer activation_layer(::Activation activation);
+    static BasicLayer relu() { return activation_layer(::Activation::ReLU); }
+    static BasicLayer tanh() { return activation_layer(::Activation::Tanh); }
+    static BasicLayer sigmoid() { return activation_layer(::Activation::Sigmoid); }
+    static BasicLayer softmax() { return activation_layer(::Activation::Softmax); }
+};
+
+// Non-owning form of a layer whose parameters live elsewhere, e.g. in a
+// memory-mapped model file. Dense weights are column-major, inputs x
+// outputs; a dense view may carry the activation that follows it.
+template <typename Scalar>
+struct BasicLayerView {
+    LayerKind kind = LayerKind::Activation;
+    Activation activation = Activation::Identity;
+    const Scalar* weights = nullptr;
+    const Scalar* biases = nullptr;
+    Eigen::Index inputs = 0;
+    Eigen::Index outputs = 0;
+};
+
+// A feed-forward network of any depth built from a list of layers.
+//
+// The layer list is compiled once at construction into an execution plan:
+// every activation that directly follows a dense layer is fused into that
+// layer's bias pass, shapes are validated, and the widest intermediate is
+// recorded so that the two ping-pong activation buffers can be sized up
+// front. Weights are immutable and shared between copies of the network.
+template <typename Scalar>
+class BasicSequential {
+public:
+    using Layer = BasicLayer<Scalar>;
+    using LayerView = BasicLayerView<Scalar>;
+    using Matrix = typename Layer::Matrix;
+    using Vector = typename Layer::Vector;
+    using BatchMatrix = RowMatrix<Scalar>;
+
+    // Same tiling as BasicMLP::predict_batch.
+    static constexpr Eigen::Index kBatchTileRows = 128;
+
+    // Two activation buffers of max_width() x rows each. Create one per
+    // thread with make_workspace() to use the allocation-free predict_into.
+    struct Workspace {
+        Eigen::Index rows = 0;
+        Vector buffers[2];
+    };
+
+    explicit BasicSequential(std::vector<Layer> layers);
+
+    // Convenience constructor for a stack of dense layers: `activation`
+    // follows every hidden layer and `output_activation` the last one.
+    BasicSequential(const std::vector<Matrix>& weights, const std::vector<Vector>& biases,
+                    Activation activation = Activation::ReLU,
+                    Activation output_activation = Activation::Identity);
+
+    // Builds a network over parameters it does not own. `storage` is kept
+    // alive for as long as any copy of the network exists.
+    BasicSequential(const std::vector<LayerView>& layers, std::shared_ptr<const void> storage);
+
+    // Thread-safe: runs in a workspace owned by the calling thread.
+    Vector predict(const Eigen::Ref<const Vector>& input) const;
+    // Uses the workspace owned by this network, so it must not be called from
+    // several threads at once; the overload taking a workspace is const and
+    // thread-safe as long as every thread passes its own.
+    void predict_into(const Eigen::Ref<const Vector>& input, Eigen::Ref<Vector> output);
+    void predict_into(const Eigen::Ref<const Vector>& input, Eigen::Ref<Vector> output,
+                      Workspace& workspace) const;
+    Workspace make_workspace(Eigen::Index rows = 1) const;
+
+    void predict_batch(const Eigen::Ref<const RowMatrixXd>& input, Eigen::Ref<BatchMatrix> output) const;
+    void predict_batch(const Eigen::Ref<const RowMatrixXf>& input, Eigen::Ref<BatchMatrix> output) const;
+    BatchMatrix predict_batch(const Eigen::Ref<const BatchMatrix>& input) const;
+
+    Eigen::Index input_size() const { return m_plan.front().inputs; }
+    Eigen::Index output_size() const { return m_plan.back().outputs; }
+    Eigen::Index max_width() const { return m_max_width; }
+
+    // The compiled execution plan: dense steps with their fused activation,
+    // and standalone activation steps that run in place.
+    const std::vector<LayerView>& plan() const { return m_plan; }
+
+    // Human-readable execution plan, one step per line.
+    std::string describe() const;
+
+private:
+    void compile(const std::vector<LayerView>& layers);
+    template <typename InputMatrix>
+    void run_batch(const InputMatrix& input, Eigen::Ref<BatchMatrix> output) const;
+    template <typename InputBlock>
+    void run_tile(const InputBlock& input, Eigen::Ref<BatchMatrix> output, Workspace& workspace) const;
+
+    // Keeps the memory the plan points into alive.
+    std::shared_ptr<const void> m_storage;
+    std::vector<LayerView> m_plan;
+    Eigen::Index m_max_width = 0;
+    Workspace m_workspace;
+};
+
+extern template struct BasicLayer<double>;
+extern template struct BasicLayer<float>;
+extern template class BasicSequential<double>;
+extern template class BasicSequential<float>;
+
+using Layer = BasicLayer<double>;
+using Sequential = BasicSequential<double>;
+using SequentialF = BasicSequential<float>;
+
+#endif // SEQUENTIAL_H
\ No newline at end of file
@@ -0,0 +1,194 @@
+#include "batch_scoring.h"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Formats the scores of one chunk into `bytes`, replacing its contents.
+// Workers format in parallel, so the writer only copies bytes.
+template <typename Scalar>
+void format_chunk(const RowMatrix<Scalar>& logits, ScoreOutput output, std::string& bytes) {
+    bytes.clear();
+    char buffer[64];
+    switch (output) {
+    case ScoreOutput::Logits:
+        bytes.assign(reinterpret_cast<const char*>(logits.data()), std::size_t(logits.size()) * sizeof(Scalar));
+        break;
+    case ScoreOutput::Labels:
+        for (Eigen::Index i = 0; i < logits.rows(); ++i) {
+            Eigen::Index label = 0;
+            logits.row(i).maxCoeff(&label);
+            char* end = std::to_chars(buffer, buffer + sizeof(buffer), label).ptr;
+            *end++ = '\n';
+            bytes.append(buffer, end);
+        }
+        break;
+    case ScoreOutput::Csv:
+        for (Eigen::Index i = 0; i < logits.rows(); ++i) {
+            for (Eigen::Index j = 0; j < logits.cols(); ++j) {
+                char* end = std::to_chars(buffer, buffer + sizeof(buffer), logits(i, j)).ptr;
+                *end++ = j + 1 < logits.cols() ? ',' : '\n';
+                bytes.append(buffer, end);
+            }
+        }
+        break;
+    }
+}
+
+} // namespace
+
+ScoreOutput parse_score_output(const std::string& name) {
+    if (name == "labels") return ScoreOutput::Labels;
+    if (name == "logits") return ScoreOutput::Logits;
+    if (name == "csv") return ScoreOutput::Csv;
+    throw std::invalid_argument("Unknown output format '" + name + "'. Expected labels, logits or csv.");
+}
+
+template <typename Scalar>
+ScoringStats score_dataset(const BasicSequential<Scalar>& network, const MappedDataset& data, std::ostream& out,
+                           const ScoringOptions& options) {
+    if (data.cols() != network.input_size()) {
+        throw std::invalid_argument("Dataset has " + std::to_string(data.cols()) + " features per row but the network expects " +
+                                    std::to_string(network.input_size()) + ".");
+    }
+    if (options.chunk_rows <= 0) {
+        throw std::invalid_argument("chunk_rows must be positive.");
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    const Eigen::Index rows = data.rows();
+    const Eigen::Index cols = data.cols();
+    const Eigen::Index chunk_rows = options.chunk_rows;
+    const std::size_t chunks = static_cast<std::size_t>((rows + chunk_rows - 1) / chunk_rows);
+    const std::size_t threads = options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    const std::size_t window = options.max_chunks_in_flight ? options.max_chunks_in_flight : 2 * threads;
+
+    // Chunk c is handed to the writer through slots[c % window]. A worker may
+    // only claim chunk c once chunk c - window has been written, which frees
+    // the slot and bounds the number of chunks held in memory.
+    struct Slot {
+        std::size_t chunk = static_cast<std::size_t>(-1);
+        std::string bytes;
+    };
+    std::vector<Slot> slots(window);
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::size_t next_chunk = 0;
+    std::size_t written = 0;
+    bool failed = false;
+    std::exception_ptr error;
+
+    const auto fail = [&](std::exception_ptr e) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!error) {
+                error = e;
+            }
+            failed = true;
+        }
+        changed.notify_all();
+    };
+
+    const auto worker = [&] {
+        RowMatrix<Scalar> input;
+        RowMatrix<Scalar> logits;
+        std::string bytes;
+        try {
+            for (;;) {
+                std::size_t chunk;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    changed.wait(lock, [&] { return failed || next_chunk >= chunks || next_chunk < written + window; });
+                    if (failed || next_chunk >= chunks) {
+                        return;
+                    }
+                    chunk = next_chunk++;
+                }
+
+                const Eigen::Index first = Eigen::Index(chunk) * chunk_rows;
+                const Eigen::Index count = std::min(chunk_rows, rows - first);
+                // Read ahead the chunk the workers will claim one round from now.
+                data.prefetch(first + chunk_rows * Eigen::Index(threads), chunk_rows);
+
+                logits.resize(count, network.output_size());
+                if (const Scalar* in_place = data.template native_rows<Scalar>(first)) {
+                    network.predict_batch(Eigen::Map<const RowMatrix<Scalar>>(in_place, count, cols), logits);
+                } else {
+                    input.resize(count, cols);
+                    data.template read_rows<Scalar>(first, input);
+                    network.predict_batch(input, logits);
+                }
+                data.release(first, count);
+                format_chunk(logits, options.output, bytes);
+
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    Slot& slot = slots[chunk % window];
+                    slot.bytes.swap(bytes);
+                    slot.chunk = chunk;
+                }
+                changed.notify_all();
+            }
+        } catch (...) {
+            fail(std::current_exception());
+        }
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(threads);
+    for (std::size_t t = 0; t < threads; ++t) {
+        pool.emplace_back(worker);
+    }
+
+    // The calling thread is the writer.
+    for (std::size_t chunk = 0; chunk < chunks; ++chunk) {
+        Slot& slot = slots[chunk % window];
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [&] { return failed || slot.chunk == chunk; });
+            if (failed) {
+                break;
+            }
+        }
+        // No worker touches this slot until `written` moves past the chunk.
+        out.write(slot.bytes.data(), static_cast<std::streamsize>(slot.bytes.size()));
+        if (!out) {
+            fail(std::make_exception_ptr(std::runtime_error("Failed to write scores.")));
+            break;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            written = chunk + 1;
+        }
+        changed.notify_all();
+    }
+
+    for (std::thread& thread : pool) {
+        thread.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    if (!out.flush()) {
+        throw std::runtime_error("Failed to write scores.");
+    }
+
+    ScoringStats stats;
+    stats.rows = rows;
+    stats.chunks = chunks;
+    stats.threads = threads;
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return stats;
+}
+
+template ScoringStats score_dataset<double>(const BasicSequential<double>&, const MappedDataset&, std::ostream&,
+                                            const ScoringOptions&);
+template ScoringStats score_dataset<float>(const BasicSequential<float>&, const MappedDataset&, std::ostream&,
+                                           const ScoringOptions&);
@@ -0,0 +1,236 @@
+#include "dataset.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+std::size_t element_size(DatasetDType dtype) {
+    switch (dtype) {
+    case DatasetDType::UInt8:
+    case DatasetDType::Int8:
+        return 1;
+    case DatasetDType::Int16:
+        return 2;
+    case DatasetDType::Int32:
+    case DatasetDType::Float32:
+        return 4;
+    case DatasetDType::Float64:
+        return 8;
+    }
+    return 0;
+}
+
+// IDX type codes.
+bool idx_dtype(unsigned char code, DatasetDType& dtype) {
+    switch (code) {
+    case 0x08: dtype = DatasetDType::UInt8; return true;
+    case 0x09: dtype = DatasetDType::Int8; return true;
+    case 0x0B: dtype = DatasetDType::Int16; return true;
+    case 0x0C: dtype = DatasetDType::Int32; return true;
+    case 0x0D: dtype = DatasetDType::Float32; return true;
+    case 0x0E: dtype = DatasetDType::Float64; return true;
+    default: return false;
+    }
+}
+
+std::uint32_t read_be32(const unsigned char* p) {
+    return (std::uint32_t(p[0]) << 24) | (std::uint32_t(p[1]) << 16) | (std::uint32_t(p[2]) << 8) | std::uint32_t(p[3]);
+}
+
+// Reads one value of type T stored at `p`, optionally big-endian.
+template <typename T>
+T load(const unsigned char* p, bool big_endian) {
+    unsigned char bytes[sizeof(T)];
+    std::memcpy(bytes, p, sizeof(T));
+    if (big_endian) {
+        for (std::size_t i = 0; i < sizeof(T) / 2; ++i) {
+            std::swap(bytes[i], bytes[sizeof(T) - 1 - i]);
+        }
+    }
+    T value;
+    std::memcpy(&value, bytes, sizeof(T));
+    return value;
+}
+
+template <typename Stored, typename Scalar>
+void convert_row(const unsigned char* src, Eigen::Index cols, bool big_endian, Scalar scale, Scalar* dst) {
+    for (Eigen::Index j = 0; j < cols; ++j) {
+        dst[j] = static_cast<Scalar>(load<Stored>(src + j * sizeof(Stored), big_endian)) * scale;
+    }
+}
+
+template <typename Scalar>
+constexpr DatasetDType dtype_of() {
+    return std::is_same_v<Scalar, float> ? DatasetDType::Float32 : DatasetDType::Float64;
+}
+
+const std::size_t kPageSize = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+
+} // namespace
+
+DatasetDType parse_dataset_dtype(const std::string& name) {
+    if (name == "u8") return DatasetDType::UInt8;
+    if (name == "i8") return DatasetDType::Int8;
+    if (name == "i16") return DatasetDType::Int16;
+    if (name == "i32") return DatasetDType::Int32;
+    if (name == "f32") return DatasetDType::Float32;
+    if (name == "f64") return DatasetDType::Float64;
+    throw std::invalid_argument("Unknown element type '" + name + "'.");
+}
+
+MappedDataset::MappedDataset(const std::string& path, const DatasetOptions& options) : m_scale(options.scale) {
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open dataset '" + path + "': " + std::strerror(errno));
+    }
+    struct stat info {};
+    if (::fstat(fd, &info) != 0) {
+        ::close(fd);
+        throw std::runtime_error("Cannot stat dataset '" + path + "': " + std::strerror(errno));
+    }
+    m_size = static_cast<std::size_t>(info.st_size);
+    if (m_size > 0) {
+        void* address = ::mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (address == MAP_FAILED) {
+            ::close(fd);
+            throw std::runtime_error("Cannot map dataset '" + path + "': " + std::strerror(errno));
+        }
+        const std::size_t size = m_size;
+        m_data = std::shared_ptr<const void>(address, [size](const void* p) { ::munmap(const_cast<void*>(p), size); });
+        // Rows are read front to back: read ahead aggressively.
+        ::madvise(address, m_size, MADV_SEQUENTIAL);
+    }
+    ::close(fd);
+
+    const auto* bytes = static_cast<const unsigned char*>(m_data.get());
+    const auto invalid = [&path](const std::string& reason) {
+        return std::runtime_error("Invalid dataset '" + path + "': " + reason);
+    };
+
+    // Looks for an IDX header whose shape accounts for the whole file.
+    bool is_idx = false;
+    if (options.format != DatasetFormat::Raw && m_size >= 8 && bytes[0] == 0 && bytes[1] == 0 &&
+        idx_dtype(bytes[2], m_dtype) && bytes[3] >= 1 && m_size >= 4 + 4 * std::size_t(bytes[3])) {
+        const std::size_t dims = bytes[3];
+        const std::uint64_t rows = read_be32(bytes + 4);
+        std::uint64_t cols = 1;
+        // A corrupt header can claim a shape whose byte count wraps around
+        // and happens to match the file size; treat that as not IDX.
+        bool overflow = false;
+        for (std::size_t d = 1; d < dims; ++d) {
+            overflow |= __builtin_mul_overflow(cols, std::uint64_t(read_be32(bytes + 4 + 4 * d)), &cols);
+        }
+        m_element_size = element_size(m_dtype);
+        m_data_offset = 4 + 4 * dims;
+        std::uint64_t data_size = 0;
+        overflow |= __builtin_mul_overflow(rows, cols, &data_size);
+        overflow |= __builtin_mul_overflow(data_size, std::uint64_t(m_element_size), &data_size);
+        const std::uint64_t max_index = std::uint64_t(std::numeric_limits<Eigen::Index>::max());
+        if (!overflow && rows <= max_index && cols <= max_index && data_size == m_size - m_data_offset) {
+            is_idx = true;
+            m_rows = static_cast<Eigen::Index>(rows);
+            m_cols = static_cast<Eigen::Index>(cols);
+        }
+    }
+
+    if (is_idx) {
+        m_format = DatasetFormat::Idx;
+        m_big_endian = true;
+    } else if (options.format == DatasetFormat::Idx) {
+        throw invalid("not an IDX file, or its header does not match the file size");
+    } else {
+        if (options.raw_cols <= 0) {
+            throw std::invalid_argument("The column count of raw dataset '" + path + "' must be given.");
+        }
+        m_format = DatasetFormat::Raw;
+        m_dtype = options.raw_dtype;
+        m_element_size = element_size(m_dtype);
+        m_data_offset = 0;
+        m_big_endian = false;
+        m_cols = options.raw_cols;
+        std::size_t row_size = 0;
+        if (__builtin_mul_overflow(std::size_t(m_cols), m_element_size, &row_size)) {
+            throw std::invalid_argument("The column count of raw dataset '" + path + "' is too large.");
+        }
+        if (m_size % row_size != 0) {
+            throw invalid(std::to_string(m_size) + " bytes is not a whole number of " + std::to_string(m_cols) +
+                          "-column rows");
+        }
+        m_rows = static_cast<Eigen::Index>(m_size / row_size);
+    }
+}
+
+const unsigned char* MappedDataset::row_bytes(Eigen::Index row) const {
+    return static_cast<const unsigned char*>(m_data.get()) + m_data_offset +
+           std::size_t(row) * std::size_t(m_cols) * m_element_size;
+}
+
+template <typename Scalar>
+void MappedDataset::read_rows(Eigen::Index first, Eigen::Ref<RowMatrix<Scalar>> out) const {
+    if (out.cols() != m_cols || first < 0 || first + out.rows() > m_rows) {
+        throw std::invalid_argument("Row range or output shape does not match the dataset.");
+    }
+    const Scalar scale = static_cast<Scalar>(m_scale);
+    for (Eigen::Index i = 0; i < out.rows(); ++i) {
+        const unsigned char* src = row_bytes(first + i);
+        Scalar* dst = out.row(i).data();
+        switch (m_dtype) {
+        case DatasetDType::UInt8: convert_row<std::uint8_t>(src, m_cols, m_big_endian, scale, dst); break;
+        case DatasetDType::Int8: convert_row<std::int8_t>(src, m_cols, m_big_endian, scale, dst); break;
+        case DatasetDType::Int16: convert_row<std::int16_t>(src, m_cols, m_big_endian, scale, dst); break;
+        case DatasetDType::Int32: convert_row<std::int32_t>(src, m_cols, m_big_endian, scale, dst); break;
+        case DatasetDType::Float32: convert_row<float>(src, m_cols, m_big_endian, scale, dst); break;
+        case DatasetDType::Float64: convert_row<double>(src, m_cols, m_big_endian, scale, dst); break;
+        }
+    }
+}
+
+template <typename Scalar>
+const Scalar* MappedDataset::native_rows(Eigen::Index first) const {
+    const unsigned char* p = row_bytes(first);
+    if (m_dtype != dtype_of<Scalar>() || m_big_endian || m_scale != 1.0 ||
+        reinterpret_cast<std::uintptr_t>(p) % alignof(Scalar) != 0) {
+        return nullptr;
+    }
+    return reinterpret_cast<const Scalar*>(p);
+}
+
+// Applies `advice` to every page holding part of the rows. Dropping a page
+// that another thread is still reading is harmless: the mapping is read-only
+// and file-backed, so the page simply faults back in.
+void MappedDataset::advise(Eigen::Index first, Eigen::Index count, int advice) const {
+    if (!m_data || count <= 0) {
+        return;
+    }
+    const std::uintptr_t begin = reinterpret_cast<std::uintptr_t>(row_bytes(first)) / kPageSize * kPageSize;
+    const std::uintptr_t end = reinterpret_cast<std::uintptr_t>(row_bytes(first + count));
+    if (end > begin) {
+        ::madvise(reinterpret_cast<void*>(begin), end - begin, advice);
+    }
+}
+
+void MappedDataset::prefetch(Eigen::Index first, Eigen::Index count) const {
+    count = std::min(count, m_rows - first);
+    advise(first, count, MADV_WILLNEED);
+}
+
+void MappedDataset::release(Eigen::Index first, Eigen::Index count) const {
+    count = std::min(count, m_rows - first);
+    advise(first, count, MADV_DONTNEED);
+}
+
+template void MappedDataset::read_rows<double>(Eigen::Index, Eigen::Ref<RowMatrix<double>>) const;
+template void MappedDataset::read_rows<float>(Eigen::Index, Eigen::Ref<RowMatrix<float>>) const;
+template const double* MappedDataset::native_rows<double>(Eigen::Index) const;
+template const float* MappedDataset::native_rows<float>(Eigen::Index) const;
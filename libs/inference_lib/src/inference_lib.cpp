@@ -1,21 +1,167 @@
 #include "inference_lib.h"
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
 
-// Helper function for ReLU
-Eigen::MatrixXd relu(const Eigen::MatrixXd& x) {
-    return x.cwiseMax(0);
+// Constructor: copies the weights and biases into the object's member variables
+template <typename Scalar>
+BasicMLP<Scalar>::BasicMLP(const Matrix& w1, const Vector& b1,
+                           const Matrix& w2, const Vector& b2)
+    : m_w1(w1), m_b1(b1), m_w2(w2), m_b2(b2), m_workspace(make_workspace()) {}
+
+// Predict method: uses the stored weights. The forward pass runs in a
+// workspace owned by the calling thread, so concurrent callers never share
+// scratch memory. Once that workspace fits this MLP, the returned vector is
+// the only allocation.
+template <typename Scalar>
+typename BasicMLP<Scalar>::Vector BasicMLP<Scalar>::predict(const Eigen::Ref<const Vector>& input) const {
+    thread_local Workspace workspace;
+    if (workspace.hidden.size() != m_w1.cols()) {
+        workspace = make_workspace();
+    }
+    Vector logits(output_size());
+    predict_into(input, logits, workspace);
+    return logits;
 }
 
-// Constructor: copies the weights and biases into the object's member variables
-MLP::MLP(const Eigen::MatrixXd& w1, const Eigen::VectorXd& b1,
-         const Eigen::MatrixXd& w2, const Eigen::VectorXd& b2)
-    : m_w1(w1), m_b1(b1), m_w2(w2), m_b2(b2) {}
-
-// Predict method: uses the stored weights
-Eigen::VectorXd MLP::predict(const Eigen::VectorXd& input) {
-    Eigen::RowVectorXd z1 = input.transpose() * m_w1;
-    z1 += m_b1.transpose();
-    Eigen::RowVectorXd a1 = relu(z1);
-    Eigen::RowVectorXd logits = a1 * m_w2;
-    logits += m_b2.transpose();
-    return logits.transpose();
-}
\ No newline at end of file
+template <typename Scalar>
+void BasicMLP<Scalar>::predict_into(const Eigen::Ref<const Vector>& input, Eigen::Ref<Vector> output) {
+    predict_into(input, output, m_workspace);
+}
+
+// Each layer's bias is loaded into its destination first, so the GEMV
+// accumulates on top of it. That leaves the ReLU as the only extra pass over
+// the hidden vector, while it is still in L1. Eigen cannot fuse the ReLU into
+// the GEMV kernel itself without evaluating the product into a temporary,
+// which would allocate.
+template <typename Scalar>
+void BasicMLP<Scalar>::predict_into(const Eigen::Ref<const Vector>& input, Eigen::Ref<Vector> output,
+                                    Workspace& workspace) const {
+    if (input.size() != input_size()) {
+        throw std::invalid_argument("Input must have " + std::to_string(input_size()) + " features.");
+    }
+    if (output.size() != output_size()) {
+        throw std::invalid_argument("Output must have " + std::to_string(output_size()) + " elements.");
+    }
+    if (workspace.hidden.size() != m_w1.cols()) {
+        throw std::invalid_argument("Workspace was not created by this MLP.");
+    }
+
+    INFERENCE_PROFILE_SCOPE(m_profiler, ProfileStage::Total);
+    INFERENCE_PROFILE_COUNT(m_profiler, 1, input.size() * sizeof(Scalar), output.size() * sizeof(Scalar));
+
+    Vector& hidden = workspace.hidden;
+    {
+        INFERENCE_PROFILE_SCOPE(m_profiler, ProfileStage::Layer1);
+        hidden = m_b1;
+        hidden.noalias() += m_w1.transpose() * input;
+    }
+    {
+        INFERENCE_PROFILE_SCOPE(m_profiler, ProfileStage::Activation);
+        hidden = hidden.cwiseMax(Scalar(0));
+    }
+    {
+        INFERENCE_PROFILE_SCOPE(m_profiler, ProfileStage::Layer2);
+        output = m_b2;
+        output.noalias() += m_w2.transpose() * hidden;
+    }
+}
+
+template <typename Scalar>
+typename BasicMLP<Scalar>::Workspace BasicMLP<Scalar>::make_workspace() const {
+    return Workspace{Vector(m_w1.cols())};
+}
+
+template <typename Scalar>
+void BasicMLP<Scalar>::predict_batch(const Eigen::Ref<const RowMatrixXd>& input, Eigen::Ref<BatchMatrix> output) const {
+    run_batch(input, output);
+}
+
+template <typename Scalar>
+void BasicMLP<Scalar>::predict_batch(const Eigen::Ref<const RowMatrixXf>& input, Eigen::Ref<BatchMatrix> output) const {
+    run_batch(input, output);
+}
+
+template <typename Scalar>
+typename BasicMLP<Scalar>::BatchMatrix BasicMLP<Scalar>::predict_batch(const Eigen::Ref<const BatchMatrix>& input) const {
+    BatchMatrix output(input.rows(), output_size());
+    run_batch(input, output);
+    return output;
+}
+
+template <typename Scalar>
+ProfileStats BasicMLP<Scalar>::stats() const {
+#ifdef INFERENCE_PROFILING
+    return m_profiler.stats();
+#else
+    return ProfileStats{};
+#endif
+}
+
+template <typename Scalar>
+void BasicMLP<Scalar>::reset_stats() {
+#ifdef INFERENCE_PROFILING
+    m_profiler.reset();
+#endif
+}
+
+// Shared batch kernel. The hidden buffer is allocated once per call and
+// reused for every tile, as is the converted tile when the input has the
+// other precision. As in predict_into, the GEMMs accumulate onto the
+// broadcast biases.
+template <typename Scalar>
+template <typename InputMatrix>
+void BasicMLP<Scalar>::run_batch(const InputMatrix& input, Eigen::Ref<BatchMatrix> output) const {
+    if (input.cols() != input_size()) {
+        throw std::invalid_argument("Input must have one row of " + std::to_string(input_size()) + " features per sample.");
+    }
+    if (output.rows() != input.rows() || output.cols() != output_size()) {
+        throw std::invalid_argument("Output must be " + std::to_string(input.rows()) + " x " +
+                                    std::to_string(output_size()) + ".");
+    }
+
+    using InputScalar = typename InputMatrix::Scalar;
+    constexpr bool kConvert = !std::is_same_v<InputScalar, Scalar>;
+    INFERENCE_PROFILE_SCOPE(m_profiler, ProfileStage::Total);
+    INFERENCE_PROFILE_COUNT(m_profiler, input.rows(), input.size() * sizeof(InputScalar),
+                            output.size() * sizeof(Scalar));
+
+    const Eigen::Index rows = input.rows();
+    const Eigen::Index tile_rows = std::min(rows, kBatchTileRows);
+    BatchMatrix hidden(tile_rows, m_w1.cols());
+    BatchMatrix converted(kConvert ? tile_rows : 0, kConvert ? input.cols() : 0);
+
+    for (Eigen::Index start = 0; start < rows; start += kBatchTileRows) {
+        const Eigen::Index n = std::min(kBatchTileRows, rows - start);
+        auto h = hidden.topRows(n);
+        auto out = output.middleRows(start, n);
+
+        if constexpr (kConvert) {
+            auto x = converted.topRows(n);
+            {
+                INFERENCE_PROFILE_SCOPE(m_profiler, ProfileStage::InputConversion);
+                x = input.middleRows(start, n).template cast<Scalar>();
+            }
+            INFERENCE_PROFILE_SCOPE(m_profiler, ProfileStage::Layer1);
+            h.rowwise() = m_b1.transpose();
+            h.noalias() += x * m_w1;
+        } else {
+            INFERENCE_PROFILE_SCOPE(m_profiler, ProfileStage::Layer1);
+            h.rowwise() = m_b1.transpose();
+            h.noalias() += input.middleRows(start, n) * m_w1;
+        }
+        {
+            INFERENCE_PROFILE_SCOPE(m_profiler, ProfileStage::Activation);
+            h = h.cwiseMax(Scalar(0));
+        }
+        {
+            INFERENCE_PROFILE_SCOPE(m_profiler, ProfileStage::Layer2);
+            out.rowwise() = m_b2.transpose();
+            out.noalias() += h * m_w2;
+        }
+    }
+}
+
+template class BasicMLP<double>;
+template class BasicMLP<float>;
\ No newline at end of file
@@ -0,0 +1,206 @@
+#include "inference_server.h"
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+InferenceServer::InferenceServer(const MLP& model, InferenceServerOptions options)
+    : m_model(model), m_options(options), m_queue(std::max<std::size_t>(options.queue_capacity, 2)) {
+    if (m_options.max_batch_size < 1) {
+        throw std::invalid_argument("max_batch_size must be at least 1.");
+    }
+    if (m_options.worker_threads == 0) {
+        m_options.worker_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    m_workers.reserve(m_options.worker_threads);
+    for (std::size_t i = 0; i < m_options.worker_threads; ++i) {
+        m_workers.emplace_back(&InferenceServer::worker_loop, this);
+    }
+}
+
+InferenceServer::~InferenceServer() {
+    shutdown();
+}
+
+std::future<Eigen::VectorXd> InferenceServer::submit(Eigen::VectorXd input) {
+    if (input.size() != m_model.input_size()) {
+        throw std::invalid_argument("Input must have " + std::to_string(m_model.input_size()) + " features.");
+    }
+
+    // m_pending, m_stopping and m_sleeping use sequentially consistent
+    // operations so that a request is never stranded: if this thread sees
+    // the server running, the workers will see the request before exiting,
+    // and either this thread sees a sleeping worker or that worker sees the
+    // pending request before it goes to sleep.
+    m_pending.fetch_add(1);
+    if (m_stopping.load()) {
+        m_pending.fetch_sub(1);
+        throw std::runtime_error("InferenceServer has been shut down.");
+    }
+
+    auto* request = new Request{std::move(input), {}, std::chrono::steady_clock::now()};
+    std::future<Eigen::VectorXd> result = request->result.get_future();
+    if (!m_queue.try_push(request)) {
+        push_blocking(request);
+    }
+
+    if (m_sleeping.load() > 0) {
+        std::lock_guard<std::mutex> lock(m_wake_mutex);
+        m_wake.notify_one();
+    }
+    return result;
+}
+
+// Slow path of submit() for a full queue: sleeps until a worker makes room.
+// Workers keep draining while m_pending is non-zero, even after shutdown(),
+// so room always appears unless they are stalled for submit_timeout.
+void InferenceServer::push_blocking(Request* request) {
+    const auto deadline = std::chrono::steady_clock::now() + m_options.submit_timeout;
+    bool pushed = false;
+    {
+        std::unique_lock<std::mutex> lock(m_wake_mutex);
+        m_blocked_submitters.fetch_add(1);
+        while (!(pushed = m_queue.try_push(request))) {
+            if (m_space.wait_until(lock, deadline) == std::cv_status::timeout) {
+                pushed = m_queue.try_push(request);
+                break;
+            }
+        }
+        m_blocked_submitters.fetch_sub(1);
+    }
+    if (!pushed) {
+        m_pending.fetch_sub(1);
+        delete request;
+        throw std::runtime_error("InferenceServer queue stayed full for " +
+                                 std::to_string(m_options.submit_timeout.count()) + " ms.");
+    }
+}
+
+void InferenceServer::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(m_wake_mutex);
+        if (m_stopping.exchange(true)) {
+            return;
+        }
+    }
+    m_wake.notify_all();
+    m_space.notify_all();
+    for (std::thread& worker : m_workers) {
+        worker.join();
+    }
+}
+
+InferenceServerStats InferenceServer::stats() const {
+    return InferenceServerStats{m_requests.load(std::memory_order_relaxed), m_batches.load(std::memory_order_relaxed)};
+}
+
+// Blocks until a request may be available. Returns false once the server is
+// stopping and nothing is left to drain.
+bool InferenceServer::wait_for_work() {
+    // The timeout is only a safety net; submit() notifies sleeping workers.
+    wait_for_request(std::chrono::steady_clock::now() + std::chrono::milliseconds(10));
+    return m_pending.load() > 0 || !m_stopping.load();
+}
+
+// Sleeps until a request is pending, the server is stopping or `deadline`
+// passes, whichever comes first.
+void InferenceServer::wait_for_request(std::chrono::steady_clock::time_point deadline) {
+    std::unique_lock<std::mutex> lock(m_wake_mutex);
+    m_sleeping.fetch_add(1);
+    m_wake.wait_until(lock, deadline, [this] {
+        return m_pending.load() > 0 || m_stopping.load();
+    });
+    m_sleeping.fetch_sub(1);
+}
+
+void InferenceServer::worker_loop() {
+    const Eigen::Index max_batch = m_options.max_batch_size;
+    std::vector<Request*> batch;
+    batch.reserve(static_cast<std::size_t>(max_batch));
+    RowMatrixXd inputs(max_batch, m_model.input_size());
+    RowMatrixXd outputs(max_batch, m_model.output_size());
+
+    for (;;) {
+        {
+            // Workers take turns collecting: the others block here rather
+            // than splitting the queued requests into small batches.
+            std::lock_guard<std::mutex> filling(m_fill_mutex);
+            if (!collect_batch(batch)) {
+                return;
+            }
+        }
+        run_batch(batch, inputs, outputs);
+        batch.clear();
+    }
+}
+
+// Pops requests into `batch` until it is full or the oldest request has
+// waited max_delay. While stopping, only takes what is already queued.
+// Returns false once the server is stopping and nothing is left to drain.
+bool InferenceServer::collect_batch(std::vector<Request*>& batch) {
+    // Under load the next request is usually a few microseconds away, so a
+    // short spin saves a sleep and a wake-up per request.
+    constexpr int kSpinPolls = 16;
+    const std::size_t max_batch = static_cast<std::size_t>(m_options.max_batch_size);
+
+    Request* request = nullptr;
+    while (!m_queue.try_pop(request)) {
+        if (!wait_for_work()) {
+            return false;
+        }
+    }
+    m_pending.fetch_sub(1);
+    batch.push_back(request);
+
+    const auto deadline = request->enqueued + m_options.max_delay;
+    int polls = 0;
+    while (batch.size() < max_batch) {
+        if (m_queue.try_pop(request)) {
+            m_pending.fetch_sub(1);
+            batch.push_back(request);
+            polls = 0;
+        } else if (m_stopping.load() || std::chrono::steady_clock::now() >= deadline) {
+            break;
+        } else if (polls < kSpinPolls) {
+            ++polls;
+            std::this_thread::yield();
+        } else {
+            wait_for_request(deadline);
+        }
+    }
+
+    // Pairs with the increment in push_blocking(): either this thread sees the
+    // blocked submitter, or the submitter's retry sees the freed slots.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_blocked_submitters.load() > 0) {
+        std::lock_guard<std::mutex> lock(m_wake_mutex);
+        m_space.notify_all();
+    }
+    return true;
+}
+
+void InferenceServer::run_batch(std::vector<Request*>& batch, RowMatrixXd& inputs, RowMatrixXd& outputs) {
+    const Eigen::Index n = static_cast<Eigen::Index>(batch.size());
+    m_requests.fetch_add(static_cast<std::uint64_t>(n), std::memory_order_relaxed);
+    m_batches.fetch_add(1, std::memory_order_relaxed);
+
+    try {
+        for (Eigen::Index i = 0; i < n; ++i) {
+            inputs.row(i) = batch[i]->input.transpose();
+        }
+        m_model.predict_batch(inputs.topRows(n), outputs.topRows(n));
+        for (Eigen::Index i = 0; i < n; ++i) {
+            batch[i]->result.set_value(outputs.row(i).transpose());
+        }
+    } catch (...) {
+        for (Request* request : batch) {
+            try {
+                request->result.set_exception(std::current_exception());
+            } catch (const std::future_error&) {
+                // Already fulfilled before the failure.
+            }
+        }
+    }
+    for (Request* request : batch) {
+        delete request;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,250 @@
+#include "model_file.h"
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+template <typename Scalar>
+constexpr ModelDType dtype_of();
+template <>
+constexpr ModelDType dtype_of<double>() { return ModelDType::Float64; }
+template <>
+constexpr ModelDType dtype_of<float>() { return ModelDType::Float32; }
+
+std::size_t dtype_size(std::uint32_t dtype) {
+    switch (static_cast<ModelDType>(dtype)) {
+        case ModelDType::Float32: return sizeof(float);
+        case ModelDType::Float64: return sizeof(double);
+    }
+    return 0;
+}
+
+std::size_t align_up(std::size_t n) {
+    return (n + kModelFileAlignment - 1) / kModelFileAlignment * kModelFileAlignment;
+}
+
+// 64-bit FNV-1a.
+std::uint64_t checksum(const unsigned char* data, std::size_t size) {
+    std::uint64_t hash = 14695981039346656037ull;
+    for (std::size_t i = 0; i < size; ++i) {
+        hash ^= data[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// Writes `data` to a uniquely named temporary file next to `path`, flushes
+// it to disk and renames it over `path`. Concurrent writers each get their
+// own temporary file, so the rename always publishes a complete file. Any
+// failure removes the temporary file and throws std::runtime_error.
+void write_file_atomically(const std::string& path, const unsigned char* data, std::size_t size) {
+    std::string temp_path = path + ".XXXXXX";
+    const int fd = ::mkstemp(&temp_path[0]);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot create a temporary file for '" + path + "': " + std::strerror(errno));
+    }
+    // Reads errno before anything else can overwrite it.
+    const auto fail = [&](const char* action, const std::string& subject, int fd_to_close) {
+        const int error = errno;
+        if (fd_to_close >= 0) {
+            ::close(fd_to_close);
+        }
+        ::unlink(temp_path.c_str());
+        return std::runtime_error(std::string(action) + " '" + subject + "': " + std::strerror(error));
+    };
+
+    // mkstemp creates the file as 0600. Keep the mode of the file being
+    // replaced, or make a new model readable by everyone.
+    struct stat existing {};
+    const mode_t mode = ::stat(path.c_str(), &existing) == 0 ? (existing.st_mode & 07777) : 0644;
+    if (::fchmod(fd, mode) != 0) {
+        throw fail("Cannot set the mode of", temp_path, fd);
+    }
+    while (size > 0) {
+        const ssize_t written = ::write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw fail("Failed to write model file", temp_path, fd);
+        }
+        data += written;
+        size -= static_cast<std::size_t>(written);
+    }
+    if (::fsync(fd) != 0) {
+        throw fail("Failed to flush model file", temp_path, fd);
+    }
+    if (::close(fd) != 0) {
+        throw fail("Failed to close model file", temp_path, -1);
+    }
+    if (::rename(temp_path.c_str(), path.c_str()) != 0) {
+        throw fail("Failed to move model file into place at", path, -1);
+    }
+
+    // Make the rename itself durable. Failing here leaves a complete file at
+    // `path`, which only a crash could still roll back, so it is not an error.
+    const std::string::size_type slash = path.find_last_of('/');
+    const std::string directory = slash == std::string::npos ? "." : slash == 0 ? "/" : path.substr(0, slash);
+    const int dir_fd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd >= 0) {
+        ::fsync(dir_fd);
+        ::close(dir_fd);
+    }
+}
+
+} // namespace
+
+// The file is assembled in memory and published with write_file_atomically.
+// Processes that still map an older version of the model keep reading their
+// own inode instead of seeing a half-written file.
+template <typename Scalar>
+void save_model(const std::string& path, const BasicSequential<Scalar>& network) {
+    const auto& plan = network.plan();
+
+    std::vector<ModelFileLayer> table(plan.size());
+    std::size_t offset = align_up(sizeof(ModelFileHeader) + plan.size() * sizeof(ModelFileLayer));
+    for (std::size_t i = 0; i < plan.size(); ++i) {
+        ModelFileLayer& entry = table[i];
+        entry = ModelFileLayer{};
+        entry.kind = static_cast<std::uint32_t>(plan[i].kind);
+        entry.activation = static_cast<std::uint32_t>(plan[i].activation);
+        entry.inputs = static_cast<std::uint64_t>(plan[i].inputs);
+        entry.outputs = static_cast<std::uint64_t>(plan[i].outputs);
+        if (plan[i].kind == LayerKind::Dense) {
+            entry.weights_offset = offset;
+            offset = align_up(offset + entry.inputs * entry.outputs * sizeof(Scalar));
+            entry.biases_offset = offset;
+            offset = align_up(offset + entry.outputs * sizeof(Scalar));
+        }
+    }
+
+    std::vector<unsigned char> buffer(offset, 0);
+    std::memcpy(buffer.data() + sizeof(ModelFileHeader), table.data(), table.size() * sizeof(ModelFileLayer));
+    for (std::size_t i = 0; i < plan.size(); ++i) {
+        if (plan[i].kind == LayerKind::Dense) {
+            std::memcpy(buffer.data() + table[i].weights_offset, plan[i].weights,
+                        table[i].inputs * table[i].outputs * sizeof(Scalar));
+            std::memcpy(buffer.data() + table[i].biases_offset, plan[i].biases, table[i].outputs * sizeof(Scalar));
+        }
+    }
+
+    ModelFileHeader header{};
+    std::memcpy(header.magic, kModelFileMagic, sizeof(header.magic));
+    header.version = kModelFileVersion;
+    header.byte_order = kModelFileByteOrderMark;
+    header.dtype = static_cast<std::uint32_t>(dtype_of<Scalar>());
+    header.layer_count = static_cast<std::uint32_t>(plan.size());
+    header.file_size = buffer.size();
+    header.checksum = checksum(buffer.data() + sizeof(header), buffer.size() - sizeof(header));
+    std::memcpy(buffer.data(), &header, sizeof(header));
+
+    write_file_atomically(path, buffer.data(), buffer.size());
+}
+
+MappedModel::MappedModel(const std::string& path, bool verify_checksum) {
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open model file '" + path + "': " + std::strerror(errno));
+    }
+    struct stat info {};
+    if (::fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(ModelFileHeader))) {
+        ::close(fd);
+        throw std::runtime_error("'" + path + "' is too small to be a model file.");
+    }
+    const std::size_t size = static_cast<std::size_t>(info.st_size);
+    void* address = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (address == MAP_FAILED) {
+        throw std::runtime_error("Cannot map model file '" + path + "': " + std::strerror(errno));
+    }
+    m_data = std::shared_ptr<const void>(address, [size](const void* p) { ::munmap(const_cast<void*>(p), size); });
+    m_size = size;
+
+    const ModelFileHeader& h = header();
+    const auto invalid = [&path](const std::string& reason) {
+        return std::runtime_error("Invalid model file '" + path + "': " + reason);
+    };
+    if (std::memcmp(h.magic, kModelFileMagic, sizeof(h.magic)) != 0) {
+        throw invalid("bad magic");
+    }
+    if (h.byte_order != kModelFileByteOrderMark) {
+        throw invalid("written with a different byte order");
+    }
+    if (h.version != kModelFileVersion) {
+        throw invalid("unsupported version " + std::to_string(h.version));
+    }
+    if (dtype_size(h.dtype) == 0) {
+        throw invalid("unknown dtype " + std::to_string(h.dtype));
+    }
+    if (h.file_size != m_size) {
+        throw invalid("truncated (" + std::to_string(m_size) + " of " + std::to_string(h.file_size) + " bytes)");
+    }
+    if (h.layer_count == 0 || sizeof(ModelFileHeader) + std::uint64_t(h.layer_count) * sizeof(ModelFileLayer) > m_size) {
+        throw invalid("bad layer table");
+    }
+
+    const std::size_t element = dtype_size(h.dtype);
+    const auto in_bounds = [this, element](std::uint64_t offset, std::uint64_t count) {
+        return offset % kModelFileAlignment == 0 && count <= m_size / element && offset <= m_size - count * element;
+    };
+    for (std::uint32_t i = 0; i < h.layer_count; ++i) {
+        const ModelFileLayer& layer = layers()[i];
+        if (layer.kind > static_cast<std::uint32_t>(LayerKind::Activation) ||
+            layer.activation > static_cast<std::uint32_t>(Activation::Softmax)) {
+            throw invalid("layer " + std::to_string(i) + " has an unknown type");
+        }
+        if (layer.kind == static_cast<std::uint32_t>(LayerKind::Dense) &&
+            (layer.inputs == 0 || layer.outputs == 0 || layer.inputs > m_size / layer.outputs ||
+             !in_bounds(layer.weights_offset, layer.inputs * layer.outputs) ||
+             !in_bounds(layer.biases_offset, layer.outputs))) {
+            throw invalid("layer " + std::to_string(i) + " points outside the file");
+        }
+    }
+
+    if (verify_checksum) {
+        const auto* bytes = static_cast<const unsigned char*>(m_data.get());
+        if (checksum(bytes + sizeof(ModelFileHeader), m_size - sizeof(ModelFileHeader)) != h.checksum) {
+            throw invalid("checksum mismatch");
+        }
+    }
+}
+
+const ModelFileLayer* MappedModel::layers() const {
+    return reinterpret_cast<const ModelFileLayer*>(static_cast<const unsigned char*>(m_data.get()) + sizeof(ModelFileHeader));
+}
+
+template <typename Scalar>
+BasicSequential<Scalar> MappedModel::network() const {
+    if (dtype() != dtype_of<Scalar>()) {
+        throw std::invalid_argument("Model file holds " +
+                                    std::string(dtype() == ModelDType::Float64 ? "float64" : "float32") +
+                                    " weights.");
+    }
+
+    const auto* base = static_cast<const unsigned char*>(m_data.get());
+    std::vector<BasicLayerView<Scalar>> views(layer_count());
+    for (std::size_t i = 0; i < views.size(); ++i) {
+        const ModelFileLayer& layer = layers()[i];
+        BasicLayerView<Scalar>& view = views[i];
+        view.kind = static_cast<LayerKind>(layer.kind);
+        view.activation = static_cast<Activation>(layer.activation);
+        view.inputs = static_cast<Eigen::Index>(layer.inputs);
+        view.outputs = static_cast<Eigen::Index>(layer.outputs);
+        if (view.kind == LayerKind::Dense) {
+            view.weights = reinterpret_cast<const Scalar*>(base + layer.weights_offset);
+            view.biases = reinterpret_cast<const Scalar*>(base + layer.biases_offset);
+        }
+    }
+    return BasicSequential<Scalar>(views, m_data);
+}
+
+template void save_model<double>(const std::string&, const BasicSequential<double>&);
+template void save_model<float>(const std::string&, const BasicSequential<float>&);
+template BasicSequential<double> MappedModel::network<double>() const;
+template BasicSequential<float> MappedModel::network<float>() const;
\ No newline at end of file
@@ -0,0 +1,193 @@
+#include "profiling.h"
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+
+const char* profile_stage_name(ProfileStage stage) {
+    switch (stage) {
+    case ProfileStage::Total: return "total";
+    case ProfileStage::InputConversion: return "input_conversion";
+    case ProfileStage::Layer1: return "layer1";
+    case ProfileStage::Activation: return "activation";
+    case ProfileStage::Layer2: return "layer2";
+    case ProfileStage::OutputCopy: return "output_copy";
+    case ProfileStage::Count: break;
+    }
+    throw std::invalid_argument("Unknown profile stage.");
+}
+
+struct alignas(64) Profiler::Shard {
+    struct Stage {
+        std::atomic<std::uint64_t> total_ns{0};
+        std::atomic<std::uint64_t> max_ns{0};
+        std::atomic<std::uint64_t> buckets[kBuckets] = {};
+    };
+    Stage stages[kProfileStageCount];
+    std::atomic<std::uint64_t> calls{0};
+    std::atomic<std::uint64_t> rows{0};
+    std::atomic<std::uint64_t> bytes_in{0};
+    std::atomic<std::uint64_t> bytes_out{0};
+};
+
+Profiler::Profiler(const Profiler&) : Profiler() {}
+
+Profiler& Profiler::operator=(const Profiler& other) {
+    if (this != &other) {
+        reset();
+    }
+    return *this;
+}
+
+Profiler::~Profiler() {
+    for (std::atomic<Shard*>& slot : m_shards) {
+        delete slot.load(std::memory_order_relaxed);
+    }
+}
+
+Profiler::Shard& Profiler::shard() {
+    // Threads are numbered on first use, so up to kShards threads never share
+    // a shard.
+    static std::atomic<std::size_t> next_thread{0};
+    thread_local const std::size_t thread_index = next_thread.fetch_add(1, std::memory_order_relaxed);
+    std::atomic<Shard*>& slot = m_shards[thread_index % kShards];
+    Shard* shard = slot.load(std::memory_order_acquire);
+    if (shard == nullptr) {
+        // Threads mapped to the same empty slot race to install a shard; the
+        // losers free theirs and use the winner's.
+        std::unique_ptr<Shard> fresh(new Shard());
+        if (slot.compare_exchange_strong(shard, fresh.get(), std::memory_order_acq_rel, std::memory_order_acquire)) {
+            shard = fresh.release();
+        }
+    }
+    return *shard;
+}
+
+std::size_t Profiler::bucket_of(std::uint64_t ns) {
+    constexpr std::uint64_t kExact = std::uint64_t(1) << kSubBucketBits;
+    if (ns < kExact) {
+        return static_cast<std::size_t>(ns);
+    }
+    if (ns >= (std::uint64_t(1) << kMaxBits)) {
+        return kBuckets - 1;
+    }
+    const std::size_t msb = 63 - static_cast<std::size_t>(__builtin_clzll(ns));
+    const std::size_t sub = static_cast<std::size_t>(ns >> (msb - kSubBucketBits)) & (kExact - 1);
+    return ((msb - kSubBucketBits + 1) << kSubBucketBits) + sub;
+}
+
+std::uint64_t Profiler::bucket_floor(std::size_t bucket) {
+    constexpr std::size_t kExact = std::size_t(1) << kSubBucketBits;
+    if (bucket < kExact) {
+        return bucket;
+    }
+    const std::size_t msb = (bucket >> kSubBucketBits) + kSubBucketBits - 1;
+    const std::uint64_t sub = bucket & (kExact - 1);
+    return (kExact + sub) << (msb - kSubBucketBits);
+}
+
+void Profiler::record(ProfileStage stage, std::uint64_t ns) {
+    Shard::Stage& s = shard().stages[static_cast<std::size_t>(stage)];
+    s.buckets[bucket_of(ns)].fetch_add(1, std::memory_order_relaxed);
+    s.total_ns.fetch_add(ns, std::memory_order_relaxed);
+    std::uint64_t max = s.max_ns.load(std::memory_order_relaxed);
+    while (ns > max && !s.max_ns.compare_exchange_weak(max, ns, std::memory_order_relaxed)) {
+    }
+}
+
+void Profiler::count(std::uint64_t rows, std::uint64_t bytes_in, std::uint64_t bytes_out) {
+    Shard& s = shard();
+    s.calls.fetch_add(1, std::memory_order_relaxed);
+    s.rows.fetch_add(rows, std::memory_order_relaxed);
+    s.bytes_in.fetch_add(bytes_in, std::memory_order_relaxed);
+    s.bytes_out.fetch_add(bytes_out, std::memory_order_relaxed);
+}
+
+ProfileStats Profiler::stats() const {
+    ProfileStats stats;
+    stats.enabled = true;
+    for (const std::atomic<Shard*>& slot : m_shards) {
+        const Shard* s = slot.load(std::memory_order_acquire);
+        if (s == nullptr) {
+            continue;
+        }
+        stats.calls += s->calls.load(std::memory_order_relaxed);
+        stats.rows += s->rows.load(std::memory_order_relaxed);
+        stats.bytes_in += s->bytes_in.load(std::memory_order_relaxed);
+        stats.bytes_out += s->bytes_out.load(std::memory_order_relaxed);
+    }
+
+    std::uint64_t merged[kBuckets];
+    for (std::size_t stage = 0; stage < kProfileStageCount; ++stage) {
+        ProfileStageStats out;
+        out.name = profile_stage_name(static_cast<ProfileStage>(stage));
+        std::uint64_t total_ns = 0;
+        std::uint64_t max_ns = 0;
+        std::fill(std::begin(merged), std::end(merged), 0);
+        for (const std::atomic<Shard*>& slot : m_shards) {
+            const Shard* shard = slot.load(std::memory_order_acquire);
+            if (shard == nullptr) {
+                continue;
+            }
+            const Shard::Stage& s = shard->stages[stage];
+            total_ns += s.total_ns.load(std::memory_order_relaxed);
+            max_ns = std::max(max_ns, s.max_ns.load(std::memory_order_relaxed));
+            for (std::size_t b = 0; b < kBuckets; ++b) {
+                merged[b] += s.buckets[b].load(std::memory_order_relaxed);
+            }
+        }
+        for (std::uint64_t n : merged) {
+            out.count += n;
+        }
+        if (out.count == 0) {
+            stats.stages.push_back(std::move(out));
+            continue;
+        }
+        out.total_ns = double(total_ns);
+        out.mean_ns = double(total_ns) / double(out.count);
+        out.max_ns = double(max_ns);
+
+        // The midpoint of the bucket holding the q-th sample, capped at the
+        // largest sample seen.
+        const auto percentile = [&](double q) {
+            const std::uint64_t rank = std::max<std::uint64_t>(1, std::uint64_t(q * double(out.count) + 0.5));
+            std::uint64_t seen = 0;
+            for (std::size_t b = 0; b < kBuckets; ++b) {
+                seen += merged[b];
+                if (seen >= rank) {
+                    const double low = double(bucket_floor(b));
+                    const double high = b + 1 < kBuckets ? double(bucket_floor(b + 1)) : low;
+                    return std::min(b < (std::size_t(1) << kSubBucketBits) ? low : 0.5 * (low + high), out.max_ns);
+                }
+            }
+            return out.max_ns;
+        };
+        out.p50_ns = percentile(0.50);
+        out.p90_ns = percentile(0.90);
+        out.p99_ns = percentile(0.99);
+        stats.stages.push_back(std::move(out));
+    }
+    return stats;
+}
+
+void Profiler::reset() {
+    // Samples recorded while resetting may survive in part.
+    for (std::atomic<Shard*>& slot : m_shards) {
+        Shard* shard = slot.load(std::memory_order_acquire);
+        if (shard == nullptr) {
+            continue;
+        }
+        Shard& s = *shard;
+        for (Shard::Stage& stage : s.stages) {
+            stage.total_ns.store(0, std::memory_order_relaxed);
+            stage.max_ns.store(0, std::memory_order_relaxed);
+            for (auto& bucket : stage.buckets) {
+                bucket.store(0, std::memory_order_relaxed);
+            }
+        }
+        s.calls.store(0, std::memory_order_relaxed);
+        s.rows.store(0, std::memory_order_relaxed);
+        s.bytes_in.store(0, std::memory_order_relaxed);
+        s.bytes_out.store(0, std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,299 @@
+#include "quantized_mlp.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define QUANTIZED_MLP_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// Rows of quantized weights and activations are padded to this many int8
+// values, which is a whole number of iterations for every kernel below.
+constexpr Eigen::Index kPadding = 64;
+
+using DotKernel = void (*)(const std::int8_t*, const std::int16_t*, Eigen::Index, std::int32_t*);
+
+// Dot products of one padded weight row `w` with `Rows` activation rows that
+// are stored `n` apart: out[r] = dot(w, x + r * n). The activations are int8
+// values already widened to int16 when they were quantized, once per sample
+// rather than once per weight row. Each chunk of `w` is loaded and widened
+// once for all rows, which is what makes predict_batch cheaper per sample
+// than predict.
+template <int Rows>
+void dot_s8_scalar(const std::int8_t* w, const std::int16_t* x, Eigen::Index n, std::int32_t* out) {
+    for (int r = 0; r < Rows; ++r) {
+        std::int32_t acc = 0;
+        for (Eigen::Index i = 0; i < n; ++i) {
+            acc += std::int32_t(w[i]) * std::int32_t(x[r * n + i]);
+        }
+        out[r] = acc;
+    }
+}
+
+#ifdef QUANTIZED_MLP_X86
+// Both SIMD kernels sign-extend the int8 weights to int16 and use
+// madd_epi16, which multiplies pairs and sums them straight into int32 lanes.
+// They require `n` to be a multiple of kPadding.
+template <int Rows>
+__attribute__((target("avx2")))
+void dot_s8_avx2(const std::int8_t* w, const std::int16_t* x, Eigen::Index n, std::int32_t* out) {
+    __m256i acc[Rows];
+    for (int r = 0; r < Rows; ++r) {
+        acc[r] = _mm256_setzero_si256();
+    }
+    for (Eigen::Index i = 0; i < n; i += 16) {
+        const __m256i vw = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(w + i)));
+        for (int r = 0; r < Rows; ++r) {
+            const __m256i vx = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + r * n + i));
+            acc[r] = _mm256_add_epi32(acc[r], _mm256_madd_epi16(vw, vx));
+        }
+    }
+    for (int r = 0; r < Rows; ++r) {
+        __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(acc[r]), _mm256_extracti128_si256(acc[r], 1));
+        sum = _mm_hadd_epi32(sum, sum);
+        sum = _mm_hadd_epi32(sum, sum);
+        out[r] = _mm_cvtsi128_si32(sum);
+    }
+}
+
+template <int Rows>
+__attribute__((target("avx512f,avx512bw")))
+void dot_s8_avx512(const std::int8_t* w, const std::int16_t* x, Eigen::Index n, std::int32_t* out) {
+    __m512i acc[Rows];
+    for (int r = 0; r < Rows; ++r) {
+        acc[r] = _mm512_setzero_si512();
+    }
+    for (Eigen::Index i = 0; i < n; i += 32) {
+        const __m512i vw = _mm512_cvtepi8_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(w + i)));
+        for (int r = 0; r < Rows; ++r) {
+            const __m512i vx = _mm512_loadu_si512(x + r * n + i);
+            acc[r] = _mm512_add_epi32(acc[r], _mm512_madd_epi16(vw, vx));
+        }
+    }
+    for (int r = 0; r < Rows; ++r) {
+        out[r] = _mm512_reduce_add_epi32(acc[r]);
+    }
+}
+#endif
+
+struct KernelChoice {
+    DotKernel single; // one activation row
+    DotKernel block;  // QuantizedMLP::kRowBlock activation rows
+    const char* name;
+};
+
+// Kernels this CPU can run, widest first; "scalar" is always last.
+const std::vector<KernelChoice>& dot_kernels() {
+    static const std::vector<KernelChoice> kernels = [] {
+        std::vector<KernelChoice> supported;
+#ifdef QUANTIZED_MLP_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512bw")) {
+            supported.push_back({dot_s8_avx512<1>, dot_s8_avx512<QuantizedMLP::kRowBlock>, "avx512bw"});
+        }
+        if (__builtin_cpu_supports("avx2")) {
+            supported.push_back({dot_s8_avx2<1>, dot_s8_avx2<QuantizedMLP::kRowBlock>, "avx2"});
+        }
+#endif
+        supported.push_back({dot_s8_scalar<1>, dot_s8_scalar<QuantizedMLP::kRowBlock>, "scalar"});
+        return supported;
+    }();
+    return kernels;
+}
+
+// The widest kernel unless set_kernel() picked another.
+std::atomic<const KernelChoice*>& active_kernel() {
+    static std::atomic<const KernelChoice*> active{&dot_kernels().front()};
+    return active;
+}
+
+const KernelChoice& dot_kernel() {
+    return *active_kernel().load(std::memory_order_acquire);
+}
+
+Eigen::Index padded(Eigen::Index n) {
+    return (n + kPadding - 1) / kPadding * kPadding;
+}
+
+// Rounds to the nearest integer, ties to even, like std::nearbyint in the
+// default rounding mode, for |v| < 2^22. Adding 1.5 * 2^23 leaves no fraction
+// bits, so the FPU rounds, and subtracting it again is exact. Unlike
+// std::nearbyintf this is not a libm call on baseline x86-64.
+inline float round_to_int(float v) {
+    constexpr float kMagic = 12582912.0f;
+    return (v + kMagic) - kMagic;
+}
+
+// Symmetric per-tensor quantization of one activation vector into [-127, 127],
+// stored as int16 for the dot kernels. Returns the scale that maps the
+// quantized values back to floats. Padding past `n` in `q` is left untouched.
+float quantize_activations(const float* x, Eigen::Index n, std::int16_t* q) {
+    const float amax = n > 0 ? Eigen::Map<const Eigen::VectorXf>(x, n).cwiseAbs().maxCoeff() : 0.0f;
+    const float scale = amax > 0.0f ? amax / 127.0f : 1.0f;
+    const float inv_scale = 1.0f / scale;
+    for (Eigen::Index i = 0; i < n; ++i) {
+        const float v = round_to_int(std::min(127.0f, std::max(-127.0f, x[i] * inv_scale)));
+        q[i] = static_cast<std::int16_t>(v);
+    }
+    return scale;
+}
+
+} // namespace
+
+QuantizedMLP::QuantizedMLP(const Eigen::MatrixXd& w1, const Eigen::VectorXd& b1,
+                           const Eigen::MatrixXd& w2, const Eigen::VectorXd& b2)
+    : m_layer1(quantize_layer(w1, b1)), m_layer2(quantize_layer(w2, b2)) {
+    if (w1.cols() != w2.rows()) {
+        throw std::invalid_argument("w1 has " + std::to_string(w1.cols()) + " outputs but w2 expects " +
+                                    std::to_string(w2.rows()) + " inputs.");
+    }
+}
+
+// Weights are given as (inputs x outputs), like MLP. Each output column gets
+// its own scale so that channels with small weights keep their precision.
+QuantizedMLP::Layer QuantizedMLP::quantize_layer(const Eigen::MatrixXd& w, const Eigen::VectorXd& b) {
+    if (b.size() != w.cols()) {
+        throw std::invalid_argument("Bias size must match the number of weight columns.");
+    }
+
+    Layer layer;
+    layer.inputs = w.rows();
+    layer.outputs = w.cols();
+    layer.stride = padded(w.rows());
+    layer.weights.assign(layer.outputs * layer.stride, 0);
+    layer.scales.resize(layer.outputs);
+    layer.biases = b.cast<float>();
+
+    for (Eigen::Index j = 0; j < layer.outputs; ++j) {
+        const double amax = w.col(j).cwiseAbs().maxCoeff();
+        const double scale = amax > 0.0 ? amax / 127.0 : 1.0;
+        std::int8_t* row = layer.weights.data() + j * layer.stride;
+        for (Eigen::Index i = 0; i < layer.inputs; ++i) {
+            const double v = std::nearbyint(w(i, j) / scale);
+            row[i] = static_cast<std::int8_t>(std::min(127.0, std::max(-127.0, v)));
+        }
+        layer.scales[j] = static_cast<float>(scale);
+    }
+    return layer;
+}
+
+QuantizedMLP::Scratch QuantizedMLP::make_scratch() const {
+    Scratch scratch;
+    scratch.input.assign(kRowBlock * m_layer1.stride, 0);
+    scratch.hidden_q.assign(kRowBlock * m_layer2.stride, 0);
+    scratch.hidden.resize(kRowBlock * m_layer1.outputs);
+    return scratch;
+}
+
+// The calling thread's scratch, re-created only when it does not fit this
+// model, so steady-state calls do not allocate.
+QuantizedMLP::Scratch& QuantizedMLP::thread_scratch() const {
+    thread_local Scratch scratch;
+    if (scratch.input.size() != std::size_t(kRowBlock * m_layer1.stride) ||
+        scratch.hidden_q.size() != std::size_t(kRowBlock * m_layer2.stride) ||
+        scratch.hidden.size() != kRowBlock * m_layer1.outputs) {
+        scratch = make_scratch();
+    }
+    return scratch;
+}
+
+// Runs `Rows` samples, `input_stride` and `output_stride` floats apart. Every
+// sample is quantized with its own scale, so a row's result does not depend
+// on which other rows share its block.
+template <int Rows>
+void QuantizedMLP::forward(const float* input, Eigen::Index input_stride, float* output, Eigen::Index output_stride,
+                           Scratch& scratch) const {
+    static_assert(Rows == 1 || Rows == kRowBlock, "no dot kernel for this block size");
+    const KernelChoice& kernel = dot_kernel();
+    const DotKernel dot = Rows == 1 ? kernel.single : kernel.block;
+    std::int32_t acc[Rows];
+
+    float input_scales[Rows];
+    for (int r = 0; r < Rows; ++r) {
+        input_scales[r] = quantize_activations(input + r * input_stride, m_layer1.inputs,
+                                               scratch.input.data() + r * m_layer1.stride);
+    }
+    for (Eigen::Index j = 0; j < m_layer1.outputs; ++j) {
+        dot(m_layer1.weights.data() + j * m_layer1.stride, scratch.input.data(), m_layer1.stride, acc);
+        for (int r = 0; r < Rows; ++r) {
+            scratch.hidden[r * m_layer1.outputs + j] =
+                std::max(0.0f, acc[r] * (input_scales[r] * m_layer1.scales[j]) + m_layer1.biases[j]);
+        }
+    }
+
+    float hidden_scales[Rows];
+    for (int r = 0; r < Rows; ++r) {
+        hidden_scales[r] = quantize_activations(scratch.hidden.data() + r * m_layer2.inputs, m_layer2.inputs,
+                                                scratch.hidden_q.data() + r * m_layer2.stride);
+    }
+    for (Eigen::Index j = 0; j < m_layer2.outputs; ++j) {
+        dot(m_layer2.weights.data() + j * m_layer2.stride, scratch.hidden_q.data(), m_layer2.stride, acc);
+        for (int r = 0; r < Rows; ++r) {
+            output[r * output_stride + j] = acc[r] * (hidden_scales[r] * m_layer2.scales[j]) + m_layer2.biases[j];
+        }
+    }
+}
+
+Eigen::VectorXf QuantizedMLP::predict(const Eigen::Ref<const Eigen::VectorXf>& input) const {
+    if (input.size() != input_size()) {
+        throw std::invalid_argument("Input must have " + std::to_string(input_size()) + " features.");
+    }
+    Eigen::VectorXf logits(output_size());
+    forward<1>(input.data(), 0, logits.data(), 0, thread_scratch());
+    return logits;
+}
+
+// Rows are processed kRowBlock at a time, so each weight row is read once per
+// block rather than once per sample; the last input.rows() % kRowBlock rows
+// run one by one.
+void QuantizedMLP::predict_batch(const Eigen::Ref<const RowMatrixXf>& input, Eigen::Ref<RowMatrixXf> output) const {
+    if (input.cols() != input_size()) {
+        throw std::invalid_argument("Input must have one row of " + std::to_string(input_size()) + " features per sample.");
+    }
+    if (output.rows() != input.rows() || output.cols() != output_size()) {
+        throw std::invalid_argument("Output must be " + std::to_string(input.rows()) + " x " +
+                                    std::to_string(output_size()) + ".");
+    }
+
+    Scratch& scratch = thread_scratch();
+    Eigen::Index r = 0;
+    for (; r + kRowBlock <= input.rows(); r += kRowBlock) {
+        forward<kRowBlock>(input.row(r).data(), input.outerStride(), output.row(r).data(), output.outerStride(), scratch);
+    }
+    for (; r < input.rows(); ++r) {
+        forward<1>(input.row(r).data(), 0, output.row(r).data(), 0, scratch);
+    }
+}
+
+RowMatrixXf QuantizedMLP::predict_batch(const Eigen::Ref<const RowMatrixXf>& input) const {
+    RowMatrixXf output(input.rows(), output_size());
+    predict_batch(input, output);
+    return output;
+}
+
+const char* QuantizedMLP::kernel_name() {
+    return dot_kernel().name;
+}
+
+std::vector<std::string> QuantizedMLP::available_kernels() {
+    std::vector<std::string> names;
+    for (const KernelChoice& kernel : dot_kernels()) {
+        names.push_back(kernel.name);
+    }
+    return names;
+}
+
+void QuantizedMLP::set_kernel(const std::string& name) {
+    for (const KernelChoice& kernel : dot_kernels()) {
+        if (name == kernel.name) {
+            active_kernel().store(&kernel, std::memory_order_release);
+            return;
+        }
+    }
+    throw std::invalid_argument("int8 kernel '" + name + "' is not available on this CPU.");
+}
\ No newline at end of file
@@ -0,0 +1,305 @@
+#include "sequential.h"
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
+Activation parse_activation(const std::string& name) {
+    if (name == "identity" || name == "none" || name == "linear") return Activation::Identity;
+    if (name == "relu") return Activation::ReLU;
+    if (name == "tanh") return Activation::Tanh;
+    if (name == "sigmoid") return Activation::Sigmoid;
+    if (name == "softmax") return Activation::Softmax;
+    throw std::invalid_argument("Unknown activation '" + name + "'.");
+}
+
+const char* activation_name(Activation activation) {
+    switch (activation) {
+        case Activation::Identity: return "identity";
+        case Activation::ReLU: return "relu";
+        case Activation::Tanh: return "tanh";
+        case Activation::Sigmoid: return "sigmoid";
+        case Activation::Softmax: return "softmax";
+    }
+    return "unknown";
+}
+
+namespace {
+
+// Adds the (optional) bias row to every row of `x` and applies `activation`,
+// all in place. Each case is a single pass over the tile.
+template <typename Scalar, typename Block>
+void apply_bias_activation(Block& x, const Scalar* biases, Activation activation) {
+    using RowVector = Eigen::Matrix<Scalar, 1, Eigen::Dynamic>;
+    if (biases) {
+        const Eigen::Map<const RowVector> b(biases, x.cols());
+        switch (activation) {
+            case Activation::Identity: x.rowwise() += b; return;
+            case Activation::ReLU: x = (x.rowwise() + b).cwiseMax(Scalar(0)); return;
+            case Activation::Tanh: x = (x.rowwise() + b).array().tanh().matrix(); return;
+            case Activation::Sigmoid: x = ((-(x.rowwise() + b)).array().exp() + Scalar(1)).inverse().matrix(); return;
+            case Activation::Softmax: x.rowwise() += b; break;
+        }
+    }
+
+    switch (activation) {
+        case Activation::Identity: return;
+        case Activation::ReLU: x = x.cwiseMax(Scalar(0)); return;
+        case Activation::Tanh: x = x.array().tanh().matrix(); return;
+        case Activation::Sigmoid: x = ((-x).array().exp() + Scalar(1)).inverse().matrix(); return;
+        case Activation::Softmax:
+            // Shift by the row maximum so exp() cannot overflow.
+            for (Eigen::Index r = 0; r < x.rows(); ++r) {
+                auto row = x.row(r);
+                row = (row.array() - row.maxCoeff()).exp().matrix();
+                row /= row.sum();
+            }
+            return;
+    }
+}
+
+} // namespace
+
+template <typename Scalar>
+BasicLayer<Scalar> BasicLayer<Scalar>::dense(const Matrix& weights, const Vector& biases) {
+    if (biases.size() != weights.cols()) {
+        throw std::invalid_argument("Dense layer has " + std::to_string(weights.cols()) + " outputs but " +
+                                    std::to_string(biases.size()) + " biases.");
+    }
+    BasicLayer layer;
+    layer.kind = Kind::Dense;
+    layer.weights = weights;
+    layer.biases = biases;
+    return layer;
+}
+
+template <typename Scalar>
+BasicLayer<Scalar> BasicLayer<Scalar>::activation_layer(::Activation activation) {
+    BasicLayer layer;
+    layer.kind = Kind::Activation;
+    layer.activation = activation;
+    return layer;
+}
+
+template <typename Scalar>
+BasicSequential<Scalar>::BasicSequential(std::vector<Layer> layers) {
+    auto owned = std::make_shared<const std::vector<Layer>>(std::move(layers));
+    std::vector<LayerView> views;
+    for (const Layer& layer : *owned) {
+        LayerView view;
+        view.kind = layer.kind;
+        view.activation = layer.activation;
+        if (layer.kind == LayerKind::Dense) {
+            view.activation = Activation::Identity;
+            view.weights = layer.weights.data();
+            view.biases = layer.biases.data();
+            view.inputs = layer.weights.rows();
+            view.outputs = layer.weights.cols();
+        }
+        views.push_back(view);
+    }
+    compile(views);
+    m_storage = std::move(owned);
+    m_workspace = make_workspace();
+}
+
+template <typename Scalar>
+BasicSequential<Scalar>::BasicSequential(const std::vector<LayerView>& layers, std::shared_ptr<const void> storage)
+    : m_storage(std::move(storage)) {
+    compile(layers);
+    m_workspace = make_workspace();
+}
+
+template <typename Scalar>
+BasicSequential<Scalar>::BasicSequential(const std::vector<Matrix>& weights, const std::vector<Vector>& biases,
+                                         Activation activation, Activation output_activation)
+    : BasicSequential([&] {
+          if (weights.size() != biases.size()) {
+              throw std::invalid_argument("Expected one bias vector per weight matrix.");
+          }
+          std::vector<Layer> layers;
+          for (std::size_t i = 0; i < weights.size(); ++i) {
+              layers.push_back(Layer::dense(weights[i], biases[i]));
+              const Activation next = i + 1 < weights.size() ? activation : output_activation;
+              if (next != Activation::Identity) {
+                  layers.push_back(Layer::activation_layer(next));
+              }
+          }
+          return layers;
+      }()) {}
+
+// Turns the layer list into the plan that the forward pass executes.
+template <typename Scalar>
+void BasicSequential<Scalar>::compile(const std::vector<LayerView>& layers) {
+    if (layers.empty() || layers.front().kind != LayerKind::Dense) {
+        throw std::invalid_argument("A Sequential network must start with a dense layer.");
+    }
+
+    m_plan.clear();
+    m_max_width = 0;
+    for (const LayerView& layer : layers) {
+        if (layer.kind == LayerKind::Dense) {
+            if (!layer.weights || !layer.biases || layer.inputs < 1 || layer.outputs < 1) {
+                throw std::invalid_argument("Dense layer " + std::to_string(m_plan.size()) + " has no parameters.");
+            }
+            if (!m_plan.empty() && m_plan.back().outputs != layer.inputs) {
+                throw std::invalid_argument("Dense layer " + std::to_string(m_plan.size()) + " expects " +
+                                            std::to_string(layer.inputs) + " inputs but receives " +
+                                            std::to_string(m_plan.back().outputs) + ".");
+            }
+            m_plan.push_back(layer);
+            m_max_width = std::max(m_max_width, layer.outputs);
+        } else if (layer.activation == Activation::Identity) {
+            continue;
+        } else if (m_plan.back().activation == Activation::Identity) {
+            // Fuse into the preceding step's bias pass.
+            m_plan.back().activation = layer.activation;
+        } else {
+            LayerView step;
+            step.inputs = step.outputs = m_plan.back().outputs;
+            step.activation = layer.activation;
+            m_plan.push_back(step);
+        }
+    }
+}
+
+template <typename Scalar>
+typename BasicSequential<Scalar>::Workspace BasicSequential<Scalar>::make_workspace(Eigen::Index rows) const {
+    Workspace workspace;
+    workspace.rows = rows;
+    workspace.buffers[0].resize(rows * m_max_width);
+    workspace.buffers[1].resize(rows * m_max_width);
+    return workspace;
+}
+
+template <typename Scalar>
+typename BasicSequential<Scalar>::Vector BasicSequential<Scalar>::predict(const Eigen::Ref<const Vector>& input) const {
+    // Per-thread scratch memory, resized when a thread switches to a wider
+    // network, so concurrent callers never share buffers.
+    thread_local Workspace workspace;
+    if (workspace.rows != 1 || workspace.buffers[0].size() != m_max_width) {
+        workspace = make_workspace();
+    }
+    Vector output(output_size());
+    predict_into(input, output, workspace);
+    return output;
+}
+
+template <typename Scalar>
+void BasicSequential<Scalar>::predict_into(const Eigen::Ref<const Vector>& input, Eigen::Ref<Vector> output) {
+    predict_into(input, output, m_workspace);
+}
+
+template <typename Scalar>
+void BasicSequential<Scalar>::predict_into(const Eigen::Ref<const Vector>& input, Eigen::Ref<Vector> output,
+                                           Workspace& workspace) const {
+    if (input.size() != input_size()) {
+        throw std::invalid_argument("Input must have " + std::to_string(input_size()) + " features.");
+    }
+    if (output.size() != output_size()) {
+        throw std::invalid_argument("Output must have " + std::to_string(output_size()) + " elements.");
+    }
+    if (workspace.rows < 1 || workspace.buffers[0].size() != workspace.rows * m_max_width) {
+        throw std::invalid_argument("Workspace was not created by this network.");
+    }
+
+    // A single sample is a one-row batch.
+    Eigen::Map<BatchMatrix> output_row(output.data(), 1, output.size());
+    run_tile(Eigen::Map<const BatchMatrix>(input.data(), 1, input.size()), output_row, workspace);
+}
+
+template <typename Scalar>
+void BasicSequential<Scalar>::predict_batch(const Eigen::Ref<const RowMatrixXd>& input, Eigen::Ref<BatchMatrix> output) const {
+    run_batch(input, output);
+}
+
+template <typename Scalar>
+void BasicSequential<Scalar>::predict_batch(const Eigen::Ref<const RowMatrixXf>& input, Eigen::Ref<BatchMatrix> output) const {
+    run_batch(input, output);
+}
+
+template <typename Scalar>
+typename BasicSequential<Scalar>::BatchMatrix BasicSequential<Scalar>::predict_batch(const Eigen::Ref<const BatchMatrix>& input) const {
+    BatchMatrix output(input.rows(), output_size());
+    run_batch(input, output);
+    return output;
+}
+
+template <typename Scalar>
+template <typename InputMatrix>
+void BasicSequential<Scalar>::run_batch(const InputMatrix& input, Eigen::Ref<BatchMatrix> output) const {
+    if (input.cols() != input_size()) {
+        throw std::invalid_argument("Input must have one row of " + std::to_string(input_size()) + " features per sample.");
+    }
+    if (output.rows() != input.rows() || output.cols() != output_size()) {
+        throw std::invalid_argument("Output must be " + std::to_string(input.rows()) + " x " +
+                                    std::to_string(output_size()) + ".");
+    }
+
+    const Eigen::Index rows = input.rows();
+    Workspace workspace = make_workspace(std::min(rows, kBatchTileRows));
+    for (Eigen::Index start = 0; start < rows; start += kBatchTileRows) {
+        const Eigen::Index n = std::min(kBatchTileRows, rows - start);
+        run_tile(input.middleRows(start, n), output.middleRows(start, n), workspace);
+    }
+}
+
+// Runs the plan over one tile of at most workspace.rows samples. The first
+// dense step reads the caller's input directly; after that the activations
+// alternate between the two workspace buffers, viewed as contiguous
+// n x width row-major matrices.
+template <typename Scalar>
+template <typename InputBlock>
+void BasicSequential<Scalar>::run_tile(const InputBlock& input, Eigen::Ref<BatchMatrix> output,
+                                       Workspace& workspace) const {
+    using WeightMap = Eigen::Map<const Matrix>;
+    using BufferMap = Eigen::Map<BatchMatrix>;
+
+    const Eigen::Index n = input.rows();
+    Scalar* buffers[2] = {workspace.buffers[0].data(), workspace.buffers[1].data()};
+    int current = 0;
+
+    const LayerView& first = m_plan.front();
+    BufferMap first_out(buffers[current], n, first.outputs);
+    first_out.noalias() = input.template cast<Scalar>() * WeightMap(first.weights, first.inputs, first.outputs);
+    apply_bias_activation(first_out, first.biases, first.activation);
+
+    for (std::size_t i = 1; i < m_plan.size(); ++i) {
+        const LayerView& step = m_plan[i];
+        if (step.kind == LayerKind::Dense) {
+            BufferMap in(buffers[current], n, step.inputs);
+            BufferMap out(buffers[1 - current], n, step.outputs);
+            out.noalias() = in * WeightMap(step.weights, step.inputs, step.outputs);
+            apply_bias_activation(out, step.biases, step.activation);
+            current = 1 - current;
+        } else {
+            BufferMap inout(buffers[current], n, step.outputs);
+            apply_bias_activation(inout, static_cast<const Scalar*>(nullptr), step.activation);
+        }
+    }
+
+    output = BufferMap(buffers[current], n, output_size());
+}
+
+template <typename Scalar>
+std::string BasicSequential<Scalar>::describe() const {
+    std::ostringstream out;
+    for (std::size_t i = 0; i < m_plan.size(); ++i) {
+        const LayerView& step = m_plan[i];
+        out << i << ": ";
+        if (step.kind == LayerKind::Dense) {
+            out << "dense " << step.inputs << " -> " << step.outputs;
+            if (step.activation != Activation::Identity) {
+                out << " + " << activation_name(step.activation);
+            }
+        } else {
+            out << activation_name(step.activation) << " (" << step.outputs << ")";
+        }
+        out << "\n";
+    }
+    return out.str();
+}
+
+template struct BasicLayer<double>;
+template struct BasicLayer<float>;
+template class BasicSequential<double>;
+template class BasicSequential<float>;
\ No newline at end of file
@@ -1,9 +1,67 @@
 #ifndef MATH_LIB_H
 #define MATH_LIB_H
 
+#include <cstddef>
+#include <string>
 #include <vector>
 
 // The function adds two vectors element-wise.
 std::vector<double> add_vectors(const std::vector<double>& a, const std::vector<double>& b);
 
-#endif // MATH_LIB_H
\ No newline at end of file
+// Elementwise and reduction kernels on contiguous float/double arrays.
+//
+// Every call is routed to the widest kernel set the CPU supports (AVX-512,
+// AVX2+FMA or portable scalar code), chosen once at startup. All kernel sets
+// produce bit-identical results: elementwise ops round exactly like the scalar
+// code, and reductions use one fixed summation order everywhere.
+//
+// Output arrays may be the same array as an input (that is how the in-place
+// overloads work) but must not partially overlap one.
+namespace math_lib {
+
+// out = a + b, a - b, a * b
+template <typename T> void add(const T* a, const T* b, T* out, std::size_t n);
+template <typename T> void sub(const T* a, const T* b, T* out, std::size_t n);
+template <typename T> void mul(const T* a, const T* b, T* out, std::size_t n);
+
+// a += b, a -= b, a *= b
+template <typename T> void add(T* a, const T* b, std::size_t n);
+template <typename T> void sub(T* a, const T* b, std::size_t n);
+template <typename T> void mul(T* a, const T* b, std::size_t n);
+
+// out = x + s
+template <typename T> void add_scalar(const T* x, T s, T* out, std::size_t n);
+template <typename T> void add_scalar(T* x, T s, std::size_t n);
+
+// out = alpha * x
+template <typename T> void scale(const T* x, T alpha, T* out, std::size_t n);
+template <typename T> void scale(T* x, T alpha, std::size_t n);
+
+// out = a * b + c, rounded once.
+template <typename T> void fma(const T* a, const T* b, const T* c, T* out, std::size_t n);
+
+// y = alpha * x + y
+template <typename T> void axpy(T alpha, const T* x, T* y, std::size_t n);
+
+// out = min(hi, max(lo, x)). NaNs are passed through.
+template <typename T> void clamp(const T* x, T lo, T hi, T* out, std::size_t n);
+template <typename T> void clamp(T* x, T lo, T hi, std::size_t n);
+
+// Sum of x, dot product of a and b, and Euclidean norm of x. 0 for n == 0.
+template <typename T> T sum(const T* x, std::size_t n);
+template <typename T> T dot(const T* a, const T* b, std::size_t n);
+template <typename T> T norm(const T* x, std::size_t n);
+
+// Name of the active kernel set: "avx512", "avx2" or "scalar".
+const char* kernel_name();
+
+// Kernel sets this CPU can run, widest first. "scalar" is always last.
+std::vector<std::string> available_kernels();
+
+// Switches every kernel to the named set, e.g. to compare a SIMD set
+// against "scalar". Throws std::invalid_argument for an unavailable set.
+void set_kernel(const std::string& name);
+
+} // namespace math_lib
+
+#endif // MATH_LIB_H
@@ -0,0 +1,169 @@
+#ifndef VECTOR_EXPR_H
+#define VECTOR_EXPR_H
+
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+#include "math_lib.h"
+
+// Expression templates over math_lib's kernels.
+//
+// `evaluate(out, (vec(x) - mean) * inv_std)` runs the whole chain in one pass:
+// the arrays are walked in tiles of kExprTile elements, each operator runs its
+// SIMD kernel on the tile, and the intermediates stay in stack buffers that
+// fit in L1. Results are identical to calling the kernels one by one.
+namespace math_lib {
+
+constexpr std::size_t kExprTile = 256;
+
+enum class ExprOp { Add, Sub, Mul };
+
+// Marker base for everything that may appear in an expression.
+struct VectorExprBase {};
+
+template <typename E>
+constexpr bool is_vector_expr_v = std::is_base_of_v<VectorExprBase, E>;
+
+// Non-owning view of a contiguous array: the leaves of an expression.
+template <typename T>
+class VectorRef : public VectorExprBase {
+public:
+    using Scalar = T;
+
+    VectorRef(const T* data, std::size_t size) : m_data(data), m_size(size) {}
+
+    std::size_t size() const { return m_size; }
+
+    // Leaves are read in place; `scratch` is not used.
+    const T* eval(std::size_t offset, std::size_t, T*) const { return m_data + offset; }
+
+private:
+    const T* m_data;
+    std::size_t m_size;
+};
+
+template <typename T>
+VectorRef<T> vec(const T* data, std::size_t size) {
+    return VectorRef<T>(data, size);
+}
+
+template <typename T>
+VectorRef<T> vec(const std::vector<T>& v) {
+    return VectorRef<T>(v.data(), v.size());
+}
+
+// lhs (op) rhs, both vector expressions.
+template <ExprOp Op, typename L, typename R>
+class BinaryExpr : public VectorExprBase {
+public:
+    using Scalar = typename L::Scalar;
+    static_assert(std::is_same_v<Scalar, typename R::Scalar>, "Operands must have the same element type.");
+
+    BinaryExpr(const L& lhs, const R& rhs) : m_lhs(lhs), m_rhs(rhs) {
+        if (lhs.size() != rhs.size()) {
+            throw std::invalid_argument("Vectors must be of the same size.");
+        }
+    }
+
+    std::size_t size() const { return m_lhs.size(); }
+
+    // Writes elements [offset, offset + n) into `out` and returns it. Both
+    // operands are fully evaluated before `out` is written.
+    const Scalar* eval(std::size_t offset, std::size_t n, Scalar* out) const {
+        alignas(64) Scalar lhs_tile[kExprTile];
+        alignas(64) Scalar rhs_tile[kExprTile];
+        const Scalar* lhs = m_lhs.eval(offset, n, lhs_tile);
+        const Scalar* rhs = m_rhs.eval(offset, n, rhs_tile);
+        if constexpr (Op == ExprOp::Add) {
+            add(lhs, rhs, out, n);
+        } else if constexpr (Op == ExprOp::Sub) {
+            sub(lhs, rhs, out, n);
+        } else {
+            mul(lhs, rhs, out, n);
+        }
+        return out;
+    }
+
+private:
+    L m_lhs;
+    R m_rhs;
+};
+
+// expr (op) scalar. Subtraction is evaluated as addition of -s, which is exact.
+template <ExprOp Op, typename E>
+class ScalarExpr : public VectorExprBase {
+public:
+    using Scalar = typename E::Scalar;
+
+    ScalarExpr(const E& expr, Scalar s) : m_expr(expr), m_scalar(s) {}
+
+    std::size_t size() const { return m_expr.size(); }
+
+    const Scalar* eval(std::size_t offset, std::size_t n, Scalar* out) const {
+        alignas(64) Scalar tile[kExprTile];
+        const Scalar* x = m_expr.eval(offset, n, tile);
+        if constexpr (Op == ExprOp::Add) {
+            add_scalar(x, m_scalar, out, n);
+        } else if constexpr (Op == ExprOp::Sub) {
+            add_scalar(x, -m_scalar, out, n);
+        } else {
+            scale(x, m_scalar, out, n);
+        }
+        return out;
+    }
+
+private:
+    E m_expr;
+    Scalar m_scalar;
+};
+
+template <typename L, typename R, typename = std::enable_if_t<is_vector_expr_v<L> && is_vector_expr_v<R>>>
+BinaryExpr<ExprOp::Add, L, R> operator+(const L& lhs, const R& rhs) { return {lhs, rhs}; }
+
+template <typename L, typename R, typename = std::enable_if_t<is_vector_expr_v<L> && is_vector_expr_v<R>>>
+BinaryExpr<ExprOp::Sub, L, R> operator-(const L& lhs, const R& rhs) { return {lhs, rhs}; }
+
+template <typename L, typename R, typename = std::enable_if_t<is_vector_expr_v<L> && is_vector_expr_v<R>>>
+BinaryExpr<ExprOp::Mul, L, R> operator*(const L& lhs, const R& rhs) { return {lhs, rhs}; }
+
+template <typename E, typename = std::enable_if_t<is_vector_expr_v<E>>>
+ScalarExpr<ExprOp::Add, E> operator+(const E& expr, typename E::Scalar s) { return {expr, s}; }
+
+template <typename E, typename = std::enable_if_t<is_vector_expr_v<E>>>
+ScalarExpr<ExprOp::Add, E> operator+(typename E::Scalar s, const E& expr) { return {expr, s}; }
+
+template <typename E, typename = std::enable_if_t<is_vector_expr_v<E>>>
+ScalarExpr<ExprOp::Sub, E> operator-(const E& expr, typename E::Scalar s) { return {expr, s}; }
+
+template <typename E, typename = std::enable_if_t<is_vector_expr_v<E>>>
+ScalarExpr<ExprOp::Mul, E> operator*(const E& expr, typename E::Scalar s) { return {expr, s}; }
+
+template <typename E, typename = std::enable_if_t<is_vector_expr_v<E>>>
+ScalarExpr<ExprOp::Mul, E> operator*(typename E::Scalar s, const E& expr) { return {expr, s}; }
+
+// Evaluates `expr` into `out`, which must hold expr.size() elements. `out`
+// may be one of the expression's arrays.
+template <typename E, typename = std::enable_if_t<is_vector_expr_v<E>>>
+void evaluate(typename E::Scalar* out, const E& expr) {
+    const std::size_t n = expr.size();
+    for (std::size_t offset = 0; offset < n; offset += kExprTile) {
+        const std::size_t count = std::min(kExprTile, n - offset);
+        const typename E::Scalar* result = expr.eval(offset, count, out + offset);
+        if (result != out + offset) {
+            std::copy(result, result + count, out + offset);
+        }
+    }
+}
+
+template <typename E, typename = std::enable_if_t<is_vector_expr_v<E>>>
+std::vector<typename E::Scalar> evaluate(const E& expr) {
+    std::vector<typename E::Scalar> out(expr.size());
+    evaluate(out.data(), expr);
+    return out;
+}
+
+} // namespace math_lib
+
+#endif // VECTOR_EXPR_H
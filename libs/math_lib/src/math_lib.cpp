@@ -1,16 +1,402 @@
 #include "math_lib.h"
+#include <atomic>
+#include <cmath>
 #include <stdexcept>
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define MATH_LIB_X86 1
+#include <immintrin.h>
+#endif
+
+// The generic kernels and ops below pass SIMD registers by value between
+// functions compiled for the baseline ISA. They are always inlined into a
+// target-specific entry point, so no such call is ever made.
+#define MATH_LIB_INLINE inline __attribute__((always_inline))
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+
 std::vector<double> add_vectors(const std::vector<double>& a, const std::vector<double>& b) {
     if (a.size() != b.size()) {
         throw std::invalid_argument("Vectors must be of the same size.");
     }
 
-    std::vector<double> result;
-    result.reserve(a.size()); // Pre-allocate the memory for efficiency
+    std::vector<double> result(a.size());
+    math_lib::add(a.data(), b.data(), result.data(), a.size());
+    return result;
+}
+
+namespace math_lib {
+namespace {
+
+// Reductions keep kLanes partial sums, element i going to lane i % kLanes,
+// and combine them with a fixed pairwise tree. Every kernel set follows this
+// order, so sums and dot products are identical whichever set runs.
+constexpr std::size_t kLanes = 16;
+
+// --- Instruction sets ---
+// Each set wraps one register type. min/max keep the x86 operand semantics
+// (the second operand is returned for NaNs and equal values) so the scalar
+// fallback and the SIMD tails round exactly like the SIMD body.
+template <typename T>
+struct ScalarIsa {
+    using Reg = T;
+    static constexpr std::size_t kWidth = 1;
+    static Reg load(const T* p) { return *p; }
+    static void store(T* p, Reg v) { *p = v; }
+    static Reg set1(T v) { return v; }
+    static Reg add(Reg a, Reg b) { return a + b; }
+    static Reg sub(Reg a, Reg b) { return a - b; }
+    static Reg mul(Reg a, Reg b) { return a * b; }
+    static Reg fma(Reg a, Reg b, Reg c) { return std::fma(a, b, c); }
+    static Reg min(Reg a, Reg b) { return a < b ? a : b; }
+    static Reg max(Reg a, Reg b) { return a > b ? a : b; }
+};
+
+#ifdef MATH_LIB_X86
+#define MATH_LIB_AVX2 __attribute__((target("avx2,fma")))
+#define MATH_LIB_AVX512 __attribute__((target("avx512f")))
+
+template <typename T> struct Avx2Isa;
+template <typename T> struct Avx512Isa;
+
+template <>
+struct Avx2Isa<double> {
+    using Reg = __m256d;
+    static constexpr std::size_t kWidth = 4;
+    MATH_LIB_AVX2 static Reg load(const double* p) { return _mm256_loadu_pd(p); }
+    MATH_LIB_AVX2 static void store(double* p, Reg v) { _mm256_storeu_pd(p, v); }
+    MATH_LIB_AVX2 static Reg set1(double v) { return _mm256_set1_pd(v); }
+    MATH_LIB_AVX2 static Reg add(Reg a, Reg b) { return _mm256_add_pd(a, b); }
+    MATH_LIB_AVX2 static Reg sub(Reg a, Reg b) { return _mm256_sub_pd(a, b); }
+    MATH_LIB_AVX2 static Reg mul(Reg a, Reg b) { return _mm256_mul_pd(a, b); }
+    MATH_LIB_AVX2 static Reg fma(Reg a, Reg b, Reg c) { return _mm256_fmadd_pd(a, b, c); }
+    MATH_LIB_AVX2 static Reg min(Reg a, Reg b) { return _mm256_min_pd(a, b); }
+    MATH_LIB_AVX2 static Reg max(Reg a, Reg b) { return _mm256_max_pd(a, b); }
+};
+
+template <>
+struct Avx2Isa<float> {
+    using Reg = __m256;
+    static constexpr std::size_t kWidth = 8;
+    MATH_LIB_AVX2 static Reg load(const float* p) { return _mm256_loadu_ps(p); }
+    MATH_LIB_AVX2 static void store(float* p, Reg v) { _mm256_storeu_ps(p, v); }
+    MATH_LIB_AVX2 static Reg set1(float v) { return _mm256_set1_ps(v); }
+    MATH_LIB_AVX2 static Reg add(Reg a, Reg b) { return _mm256_add_ps(a, b); }
+    MATH_LIB_AVX2 static Reg sub(Reg a, Reg b) { return _mm256_sub_ps(a, b); }
+    MATH_LIB_AVX2 static Reg mul(Reg a, Reg b) { return _mm256_mul_ps(a, b); }
+    MATH_LIB_AVX2 static Reg fma(Reg a, Reg b, Reg c) { return _mm256_fmadd_ps(a, b, c); }
+    MATH_LIB_AVX2 static Reg min(Reg a, Reg b) { return _mm256_min_ps(a, b); }
+    MATH_LIB_AVX2 static Reg max(Reg a, Reg b) { return _mm256_max_ps(a, b); }
+};
+
+template <>
+struct Avx512Isa<double> {
+    using Reg = __m512d;
+    static constexpr std::size_t kWidth = 8;
+    MATH_LIB_AVX512 static Reg load(const double* p) { return _mm512_loadu_pd(p); }
+    MATH_LIB_AVX512 static void store(double* p, Reg v) { _mm512_storeu_pd(p, v); }
+    MATH_LIB_AVX512 static Reg set1(double v) { return _mm512_set1_pd(v); }
+    MATH_LIB_AVX512 static Reg add(Reg a, Reg b) { return _mm512_add_pd(a, b); }
+    MATH_LIB_AVX512 static Reg sub(Reg a, Reg b) { return _mm512_sub_pd(a, b); }
+    MATH_LIB_AVX512 static Reg mul(Reg a, Reg b) { return _mm512_mul_pd(a, b); }
+    MATH_LIB_AVX512 static Reg fma(Reg a, Reg b, Reg c) { return _mm512_fmadd_pd(a, b, c); }
+    // The unmasked min/max intrinsics trip a -Wmaybe-uninitialized false
+    // positive in GCC 12; the zero-masked forms with a full mask are the same
+    // instruction.
+    MATH_LIB_AVX512 static Reg min(Reg a, Reg b) { return _mm512_maskz_min_pd(0xFF, a, b); }
+    MATH_LIB_AVX512 static Reg max(Reg a, Reg b) { return _mm512_maskz_max_pd(0xFF, a, b); }
+};
+
+template <>
+struct Avx512Isa<float> {
+    using Reg = __m512;
+    static constexpr std::size_t kWidth = 16;
+    MATH_LIB_AVX512 static Reg load(const float* p) { return _mm512_loadu_ps(p); }
+    MATH_LIB_AVX512 static void store(float* p, Reg v) { _mm512_storeu_ps(p, v); }
+    MATH_LIB_AVX512 static Reg set1(float v) { return _mm512_set1_ps(v); }
+    MATH_LIB_AVX512 static Reg add(Reg a, Reg b) { return _mm512_add_ps(a, b); }
+    MATH_LIB_AVX512 static Reg sub(Reg a, Reg b) { return _mm512_sub_ps(a, b); }
+    MATH_LIB_AVX512 static Reg mul(Reg a, Reg b) { return _mm512_mul_ps(a, b); }
+    MATH_LIB_AVX512 static Reg fma(Reg a, Reg b, Reg c) { return _mm512_fmadd_ps(a, b, c); }
+    MATH_LIB_AVX512 static Reg min(Reg a, Reg b) { return _mm512_maskz_min_ps(0xFFFF, a, b); }
+    MATH_LIB_AVX512 static Reg max(Reg a, Reg b) { return _mm512_maskz_max_ps(0xFFFF, a, b); }
+};
+#endif
+
+// --- Elementwise ops ---
+// Called with an instruction set tag, so one definition serves both the
+// SIMD body and the scalar tail of every kernel.
+struct AddOp {
+    template <typename I, typename R> MATH_LIB_INLINE R operator()(I, const R& a, const R& b) const { return I::add(a, b); }
+};
+struct SubOp {
+    template <typename I, typename R> MATH_LIB_INLINE R operator()(I, const R& a, const R& b) const { return I::sub(a, b); }
+};
+struct MulOp {
+    template <typename I, typename R> MATH_LIB_INLINE R operator()(I, const R& a, const R& b) const { return I::mul(a, b); }
+};
+struct FmaOp {
+    template <typename I, typename R> MATH_LIB_INLINE R operator()(I, const R& a, const R& b, const R& c) const { return I::fma(a, b, c); }
+};
+template <typename T>
+struct AddScalarOp {
+    T s;
+    template <typename I, typename R> MATH_LIB_INLINE R operator()(I, const R& x) const { return I::add(x, I::set1(s)); }
+};
+template <typename T>
+struct ScaleOp {
+    T alpha;
+    template <typename I, typename R> MATH_LIB_INLINE R operator()(I, const R& x) const { return I::mul(I::set1(alpha), x); }
+};
+template <typename T>
+struct AxpyOp {
+    T alpha;
+    template <typename I, typename R> MATH_LIB_INLINE R operator()(I, const R& x, const R& y) const { return I::add(I::mul(I::set1(alpha), x), y); }
+};
+template <typename T>
+struct ClampOp {
+    T lo, hi;
+    template <typename I, typename R> MATH_LIB_INLINE R operator()(I, const R& x) const { return I::min(I::set1(hi), I::max(I::set1(lo), x)); }
+};
+
+// --- Generic kernels ---
+template <typename I, typename T, typename Op>
+MATH_LIB_INLINE void unary_kernel(const T* x, T* out, std::size_t n, Op op) {
+    std::size_t i = 0;
+    for (; i + I::kWidth <= n; i += I::kWidth) {
+        I::store(out + i, op(I{}, I::load(x + i)));
+    }
+    for (; i < n; ++i) {
+        out[i] = op(ScalarIsa<T>{}, x[i]);
+    }
+}
+
+template <typename I, typename T, typename Op>
+MATH_LIB_INLINE void binary_kernel(const T* a, const T* b, T* out, std::size_t n, Op op) {
+    std::size_t i = 0;
+    for (; i + I::kWidth <= n; i += I::kWidth) {
+        I::store(out + i, op(I{}, I::load(a + i), I::load(b + i)));
+    }
+    for (; i < n; ++i) {
+        out[i] = op(ScalarIsa<T>{}, a[i], b[i]);
+    }
+}
 
-    for (size_t i = 0; i < a.size(); ++i) {
-        result.push_back(a[i] + b[i]);
+template <typename I, typename T, typename Op>
+MATH_LIB_INLINE void ternary_kernel(const T* a, const T* b, const T* c, T* out, std::size_t n, Op op) {
+    std::size_t i = 0;
+    for (; i + I::kWidth <= n; i += I::kWidth) {
+        I::store(out + i, op(I{}, I::load(a + i), I::load(b + i), I::load(c + i)));
     }
-    return result;
-}
\ No newline at end of file
+    for (; i < n; ++i) {
+        out[i] = op(ScalarIsa<T>{}, a[i], b[i], c[i]);
+    }
+}
+
+template <typename T>
+T combine_lanes(T* lanes) {
+    for (std::size_t width = kLanes / 2; width > 0; width /= 2) {
+        for (std::size_t l = 0; l < width; ++l) {
+            lanes[l] = lanes[l] + lanes[l + width];
+        }
+    }
+    return lanes[0];
+}
+
+// Sum of a[i] (b == nullptr) or of a[i] * b[i], in the canonical lane order.
+template <typename I, typename T>
+MATH_LIB_INLINE T reduce_kernel(const T* a, const T* b, std::size_t n) {
+    constexpr std::size_t kRegs = kLanes / I::kWidth;
+    typename I::Reg acc[kRegs];
+    for (std::size_t r = 0; r < kRegs; ++r) {
+        acc[r] = I::set1(T(0));
+    }
+
+    std::size_t i = 0;
+    for (; i + kLanes <= n; i += kLanes) {
+        for (std::size_t r = 0; r < kRegs; ++r) {
+            const typename I::Reg x = I::load(a + i + r * I::kWidth);
+            acc[r] = I::add(acc[r], b ? I::mul(x, I::load(b + i + r * I::kWidth)) : x);
+        }
+    }
+
+    alignas(64) T lanes[kLanes];
+    for (std::size_t r = 0; r < kRegs; ++r) {
+        I::store(lanes + r * I::kWidth, acc[r]);
+    }
+    for (std::size_t l = 0; i < n; ++i, ++l) {
+        lanes[l] = lanes[l] + (b ? a[i] * b[i] : a[i]);
+    }
+    return combine_lanes(lanes);
+}
+
+// --- Kernel sets ---
+template <typename T>
+struct KernelSet {
+    const char* name;
+    void (*add)(const T*, const T*, T*, std::size_t);
+    void (*sub)(const T*, const T*, T*, std::size_t);
+    void (*mul)(const T*, const T*, T*, std::size_t);
+    void (*add_scalar)(const T*, T, T*, std::size_t);
+    void (*scale)(const T*, T, T*, std::size_t);
+    void (*fma)(const T*, const T*, const T*, T*, std::size_t);
+    void (*axpy)(T, const T*, T*, std::size_t);
+    void (*clamp)(const T*, T, T, T*, std::size_t);
+    T (*sum)(const T*, std::size_t);
+    T (*dot)(const T*, const T*, std::size_t);
+};
+
+// Entry points of one kernel set. ATTR carries the target ISA and flattens
+// the generic kernel and its ops into the entry point.
+#define MATH_LIB_DEFINE_KERNEL_SET(NS, ATTR, ISA)                                                    \
+    namespace NS {                                                                                    \
+    template <typename T> ATTR void add(const T* a, const T* b, T* out, std::size_t n) {              \
+        binary_kernel<ISA<T>>(a, b, out, n, AddOp{});                                                 \
+    }                                                                                                 \
+    template <typename T> ATTR void sub(const T* a, const T* b, T* out, std::size_t n) {              \
+        binary_kernel<ISA<T>>(a, b, out, n, SubOp{});                                                 \
+    }                                                                                                 \
+    template <typename T> ATTR void mul(const T* a, const T* b, T* out, std::size_t n) {              \
+        binary_kernel<ISA<T>>(a, b, out, n, MulOp{});                                                 \
+    }                                                                                                 \
+    template <typename T> ATTR void add_scalar(const T* x, T s, T* out, std::size_t n) {              \
+        unary_kernel<ISA<T>>(x, out, n, AddScalarOp<T>{s});                                           \
+    }                                                                                                 \
+    template <typename T> ATTR void scale(const T* x, T alpha, T* out, std::size_t n) {               \
+        unary_kernel<ISA<T>>(x, out, n, ScaleOp<T>{alpha});                                           \
+    }                                                                                                 \
+    template <typename T> ATTR void fma(const T* a, const T* b, const T* c, T* out, std::size_t n) {  \
+        ternary_kernel<ISA<T>>(a, b, c, out, n, FmaOp{});                                             \
+    }                                                                                                 \
+    template <typename T> ATTR void axpy(T alpha, const T* x, T* y, std::size_t n) {                  \
+        binary_kernel<ISA<T>>(x, y, y, n, AxpyOp<T>{alpha});                                          \
+    }                                                                                                 \
+    template <typename T> ATTR void clamp(const T* x, T lo, T hi, T* out, std::size_t n) {            \
+        unary_kernel<ISA<T>>(x, out, n, ClampOp<T>{lo, hi});                                          \
+    }                                                                                                 \
+    template <typename T> ATTR T sum(const T* x, std::size_t n) {                                     \
+        return reduce_kernel<ISA<T>, T>(x, nullptr, n);                                               \
+    }                                                                                                 \
+    template <typename T> ATTR T dot(const T* a, const T* b, std::size_t n) {                         \
+        return reduce_kernel<ISA<T>, T>(a, b, n);                                                     \
+    }                                                                                                 \
+    template <typename T> KernelSet<T> kernel_set() {                                                 \
+        return {#NS, add<T>, sub<T>, mul<T>, add_scalar<T>, scale<T>, fma<T>, axpy<T>, clamp<T>,      \
+                sum<T>, dot<T>};                                                                      \
+    }                                                                                                 \
+    }
+
+MATH_LIB_DEFINE_KERNEL_SET(scalar, , ScalarIsa)
+#ifdef MATH_LIB_X86
+MATH_LIB_DEFINE_KERNEL_SET(avx2, MATH_LIB_AVX2 __attribute__((flatten)), Avx2Isa)
+MATH_LIB_DEFINE_KERNEL_SET(avx512, MATH_LIB_AVX512 __attribute__((flatten)), Avx512Isa)
+#endif
+
+// Kernel sets the running CPU supports, widest first. Evaluated once.
+template <typename T>
+const std::vector<KernelSet<T>>& kernel_sets() {
+    static const std::vector<KernelSet<T>> sets = [] {
+        std::vector<KernelSet<T>> supported;
+#ifdef MATH_LIB_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f")) {
+            supported.push_back(avx512::kernel_set<T>());
+        }
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+            supported.push_back(avx2::kernel_set<T>());
+        }
+#endif
+        supported.push_back(scalar::kernel_set<T>());
+        return supported;
+    }();
+    return sets;
+}
+
+template <typename T>
+std::atomic<const KernelSet<T>*>& active_slot() {
+    static std::atomic<const KernelSet<T>*> active{&kernel_sets<T>().front()};
+    return active;
+}
+
+template <typename T>
+const KernelSet<T>& active() {
+    return *active_slot<T>().load(std::memory_order_acquire);
+}
+
+} // namespace
+
+template <typename T> void add(const T* a, const T* b, T* out, std::size_t n) { active<T>().add(a, b, out, n); }
+template <typename T> void sub(const T* a, const T* b, T* out, std::size_t n) { active<T>().sub(a, b, out, n); }
+template <typename T> void mul(const T* a, const T* b, T* out, std::size_t n) { active<T>().mul(a, b, out, n); }
+template <typename T> void add(T* a, const T* b, std::size_t n) { active<T>().add(a, b, a, n); }
+template <typename T> void sub(T* a, const T* b, std::size_t n) { active<T>().sub(a, b, a, n); }
+template <typename T> void mul(T* a, const T* b, std::size_t n) { active<T>().mul(a, b, a, n); }
+
+template <typename T> void add_scalar(const T* x, T s, T* out, std::size_t n) { active<T>().add_scalar(x, s, out, n); }
+template <typename T> void add_scalar(T* x, T s, std::size_t n) { active<T>().add_scalar(x, s, x, n); }
+template <typename T> void scale(const T* x, T alpha, T* out, std::size_t n) { active<T>().scale(x, alpha, out, n); }
+template <typename T> void scale(T* x, T alpha, std::size_t n) { active<T>().scale(x, alpha, x, n); }
+
+template <typename T> void fma(const T* a, const T* b, const T* c, T* out, std::size_t n) {
+    active<T>().fma(a, b, c, out, n);
+}
+template <typename T> void axpy(T alpha, const T* x, T* y, std::size_t n) { active<T>().axpy(alpha, x, y, n); }
+
+template <typename T> void clamp(const T* x, T lo, T hi, T* out, std::size_t n) { active<T>().clamp(x, lo, hi, out, n); }
+template <typename T> void clamp(T* x, T lo, T hi, std::size_t n) { active<T>().clamp(x, lo, hi, x, n); }
+
+template <typename T> T sum(const T* x, std::size_t n) { return active<T>().sum(x, n); }
+template <typename T> T dot(const T* a, const T* b, std::size_t n) { return active<T>().dot(a, b, n); }
+template <typename T> T norm(const T* x, std::size_t n) { return std::sqrt(active<T>().dot(x, x, n)); }
+
+const char* kernel_name() {
+    return active<double>().name;
+}
+
+std::vector<std::string> available_kernels() {
+    std::vector<std::string> names;
+    for (const KernelSet<double>& set : kernel_sets<double>()) {
+        names.push_back(set.name);
+    }
+    return names;
+}
+
+void set_kernel(const std::string& name) {
+    const auto select = [&name](auto& slot, const auto& sets) {
+        for (const auto& set : sets) {
+            if (name == set.name) {
+                slot.store(&set, std::memory_order_release);
+                return true;
+            }
+        }
+        return false;
+    };
+    if (!select(active_slot<double>(), kernel_sets<double>()) || !select(active_slot<float>(), kernel_sets<float>())) {
+        throw std::invalid_argument("Kernel set '" + name + "' is not available on this CPU.");
+    }
+}
+
+#define MATH_LIB_INSTANTIATE(T)                                            \
+    template void add<T>(const T*, const T*, T*, std::size_t);             \
+    template void sub<T>(const T*, const T*, T*, std::size_t);             \
+    template void mul<T>(const T*, const T*, T*, std::size_t);             \
+    template void add<T>(T*, const T*, std::size_t);                       \
+    template void sub<T>(T*, const T*, std::size_t);                       \
+    template void mul<T>(T*, const T*, std::size_t);                       \
+    template void add_scalar<T>(const T*, T, T*, std::size_t);             \
+    template void add_scalar<T>(T*, T, std::size_t);                       \
+    template void scale<T>(const T*, T, T*, std::size_t);                  \
+    template void scale<T>(T*, T, std::size_t);                            \
+    template void fma<T>(const T*, const T*, const T*, T*, std::size_t);   \
+    template void axpy<T>(T, const T*, T*, std::size_t);                   \
+    template void clamp<T>(const T*, T, T, T*, std::size_t);               \
+    template void clamp<T>(T*, T, T, std::size_t);                         \
+    template T sum<T>(const T*, std::size_t);                              \
+    template T dot<T>(const T*, const T*, std::size_t);                    \
+    template T norm<T>(const T*, std::size_t);
+
+MATH_LIB_INSTANTIATE(float)
+MATH_LIB_INSTANTIATE(double)
+
+} // namespace math_lib
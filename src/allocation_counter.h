@@ -0,0 +1,40 @@
+#ifndef ALLOCATION_COUNTER_H
+#define ALLOCATION_COUNTER_H
+
+// Counts heap allocations made anywhere in the process. On glibc the
+// executable interposes malloc/calloc/realloc and forwards to the real
+// allocator, which also catches allocations made by Eigen and the standard
+// library. Include this header from exactly one translation unit of an
+// executable.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+static std::atomic<std::uint64_t> g_allocations{0};
+
+#ifdef __GLIBC__
+extern "C" {
+void* __libc_malloc(std::size_t size);
+void* __libc_calloc(std::size_t count, std::size_t size);
+void* __libc_realloc(void* ptr, std::size_t size);
+
+void* malloc(std::size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+void* calloc(std::size_t count, std::size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(count, size);
+}
+void* realloc(void* ptr, std::size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(ptr, size);
+}
+}
+constexpr bool kCountsAllocations = true;
+#else
+constexpr bool kCountsAllocations = false;
+#endif
+
+#endif // ALLOCATION_COUNTER_H
@@ -1,17 +1,474 @@
 #include <pybind11/pybind11.h>
 #include <pybind11/eigen.h>
+#include <pybind11/numpy.h>
+#include <pybind11/stl.h>
+#include <type_traits>
+#include "fixed_sequential.h"
 #include "inference_lib.h"
+#include "inference_server.h"
+#include "math_lib.h"
+#include "model_file.h"
+#include "quantized_mlp.h"
+#include "sequential.h"
+#include "vector_expr.h"
 
 namespace py = pybind11;
 
+// Python handle for a pending InferenceServer request. Waiting releases the
+// GIL so other Python threads keep submitting while this one blocks.
+struct InferenceFuture {
+    std::shared_future<Eigen::VectorXd> future;
+
+    bool done() const {
+        return future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    }
+
+    Eigen::VectorXd result(const py::object& timeout) const {
+        const bool wait_forever = timeout.is_none();
+        const double seconds = wait_forever ? 0.0 : timeout.cast<double>();
+        bool ready = true;
+        {
+            py::gil_scoped_release release;
+            if (wait_forever) {
+                future.wait();
+            } else {
+                ready = future.wait_for(std::chrono::duration<double>(seconds)) == std::future_status::ready;
+            }
+        }
+        if (!ready) {
+            PyErr_SetString(PyExc_TimeoutError, "InferenceFuture.result() timed out");
+            throw py::error_already_set();
+        }
+        // Rethrows anything the batch raised.
+        return future.get();
+    }
+};
+
+// Hands a result to Python as a NumPy array that takes over its buffer. In
+// profiling builds an MLP records this as its output_copy stage.
+template <typename Model, typename Result>
+py::object to_numpy(const Model&, Result&& result) {
+    return py::cast(std::forward<Result>(result));
+}
+
+#ifdef INFERENCE_PROFILING
+template <typename Scalar, typename Result>
+py::object to_numpy(const BasicMLP<Scalar>& model, Result&& result) {
+    INFERENCE_PROFILE_SCOPE(model.profiler(), ProfileStage::OutputCopy);
+    return py::cast(std::forward<Result>(result));
+}
+#endif
+
+// A single sample as a C-contiguous array of the model's scalar type.
+template <typename Scalar>
+using InputArray = py::array_t<Scalar, py::array::c_style | py::array::forcecast>;
+
+// Returns `input` itself if it already is an InputArray, and a converted copy
+// otherwise (float64 into a float32 model, lists, strided views). In profiling
+// builds an MLP records the conversion as its input_conversion stage.
+template <typename Scalar>
+InputArray<Scalar> as_input_array(const py::object& input) {
+    // Throws TypeError/ValueError if numpy cannot convert `input`.
+    InputArray<Scalar> array(input);
+    if (array.ndim() > 2 || (array.ndim() == 2 && array.shape(0) != 1 && array.shape(1) != 1)) {
+        throw std::invalid_argument("Input must be a 1-D array.");
+    }
+    return array;
+}
+
+template <typename Model>
+InputArray<typename Model::Vector::Scalar> to_input_array(const Model&, const py::object& input) {
+    return as_input_array<typename Model::Vector::Scalar>(input);
+}
+
+#ifdef INFERENCE_PROFILING
+template <typename Scalar>
+InputArray<Scalar> to_input_array(const BasicMLP<Scalar>& model, const py::object& input) {
+    if (py::isinstance<InputArray<Scalar>>(input)) {
+        return as_input_array<Scalar>(input);
+    }
+    INFERENCE_PROFILE_SCOPE(model.profiler(), ProfileStage::InputConversion);
+    return as_input_array<Scalar>(input);
+}
+#endif
+
+// Converts ProfileStats into a dict; times are in nanoseconds.
+py::dict profile_stats_to_dict(const ProfileStats& stats) {
+    py::dict stages;
+    for (const ProfileStageStats& stage : stats.stages) {
+        py::dict entry;
+        entry["count"] = stage.count;
+        entry["total_ns"] = stage.total_ns;
+        entry["mean_ns"] = stage.mean_ns;
+        entry["p50_ns"] = stage.p50_ns;
+        entry["p90_ns"] = stage.p90_ns;
+        entry["p99_ns"] = stage.p99_ns;
+        entry["max_ns"] = stage.max_ns;
+        stages[py::str(stage.name)] = entry;
+    }
+    py::dict result;
+    result["enabled"] = stats.enabled;
+    result["calls"] = stats.calls;
+    result["rows"] = stats.rows;
+    result["bytes_in"] = stats.bytes_in;
+    result["bytes_out"] = stats.bytes_out;
+    result["stages"] = stages;
+    return result;
+}
+
+// Adds predict, predict_into and predict_batch to a Python class wrapping
+// BasicMLP or BasicSequential; both expose the same inference interface.
+template <typename Model, typename PyClass>
+void def_inference_methods(PyClass& cls) {
+    using Vector = typename Model::Vector;
+    using BatchMatrix = typename Model::BatchMatrix;
+
+    cls
+        // This binds the 'predict' method. Input in the model's dtype is read
+        // in place; anything else is converted by to_input_array.
+        .def("predict",
+             [](const Model& self, const py::object& input) {
+                 const auto array = to_input_array(self, input);
+                 const Eigen::Map<const Vector> x(array.data(), array.size());
+                 return to_numpy(self, self.predict(x));
+             },
+             py::arg("input"), "Performs a forward pass with the stored weights.")
+        // Allocation-free variant: `out` must be an array of output_size()
+        // elements in the model's dtype and is written in place. It uses the model's own
+        // workspace, so the GIL is kept to serialise callers sharing one object.
+        .def("predict_into",
+             py::overload_cast<const Eigen::Ref<const Vector>&, Eigen::Ref<Vector>>(&Model::predict_into),
+             py::arg("input"), py::arg("out").noconvert(),
+             "Performs a forward pass and writes the logits into `out`.")
+        // Batched inference. Eigen::Ref maps C-contiguous float64/float32 arrays
+        // directly, so the batch is not copied; pybind11 tries the exact-dtype
+        // overloads first and only falls back to a converting copy for other
+        // inputs. The GIL is released while the GEMMs run.
+        .def("predict_batch",
+             [](const Model& self, const Eigen::Ref<const RowMatrixXd>& input) {
+                 BatchMatrix output(input.rows(), self.output_size());
+                 {
+                     py::gil_scoped_release release;
+                     self.predict_batch(input, output);
+                 }
+                 return to_numpy(self, std::move(output));
+             },
+             py::arg("input"),
+             "Runs the forward pass on one sample per row and returns one row of logits per sample.")
+        .def("predict_batch",
+             [](const Model& self, const Eigen::Ref<const RowMatrixXf>& input) {
+                 BatchMatrix output(input.rows(), self.output_size());
+                 {
+                     py::gil_scoped_release release;
+                     self.predict_batch(input, output);
+                 }
+                 return to_numpy(self, std::move(output));
+             },
+             py::arg("input"))
+        // Variants that write into a caller-provided, C-contiguous array.
+        .def("predict_batch",
+             py::overload_cast<const Eigen::Ref<const RowMatrixXd>&, Eigen::Ref<BatchMatrix>>(&Model::predict_batch, py::const_),
+             py::arg("input"), py::arg("out").noconvert(), py::call_guard<py::gil_scoped_release>())
+        .def("predict_batch",
+             py::overload_cast<const Eigen::Ref<const RowMatrixXf>&, Eigen::Ref<BatchMatrix>>(&Model::predict_batch, py::const_),
+             py::arg("input"), py::arg("out").noconvert(), py::call_guard<py::gil_scoped_release>());
+}
+
+// Binds one precision of BasicMLP under `name`. Weights passed from Python in
+// another dtype are converted once by the constructor.
+template <typename Scalar>
+void bind_mlp(py::module_& m, const char* name) {
+    using Model = BasicMLP<Scalar>;
+    using Matrix = typename Model::Matrix;
+    using Vector = typename Model::Vector;
+
+    // This defines a new class in our Python module
+    py::class_<Model> cls(m, name);
+    // This binds the C++ constructor. py::init<...>() specifies the argument types.
+    cls.def(py::init<const Matrix&, const Vector&, const Matrix&, const Vector&>());
+    def_inference_methods<Model>(cls);
+    // Per-stage latency histograms. Only populated when the extension was
+    // built with -DINFERENCE_PROFILING=ON; otherwise "enabled" is False.
+    cls.def("stats", [](const Model& self) { return profile_stats_to_dict(self.stats()); },
+            "Returns call, row and byte counters and per-stage latency percentiles.")
+        .def("reset_stats", &Model::reset_stats, "Clears the counters and histograms.");
+}
+
+// Converts a Python layer list into C++ layers: each item is either a
+// (weights, biases) pair for a dense layer or an activation name.
+template <typename Scalar>
+std::vector<BasicLayer<Scalar>> layers_from_python(const py::list& items) {
+    using Layer = BasicLayer<Scalar>;
+    std::vector<Layer> layers;
+    for (const py::handle item : items) {
+        if (py::isinstance<py::str>(item)) {
+            layers.push_back(Layer::activation_layer(parse_activation(item.cast<std::string>())));
+        } else {
+            auto dense = item.cast<std::pair<typename Layer::Matrix, typename Layer::Vector>>();
+            layers.push_back(Layer::dense(dense.first, dense.second));
+        }
+    }
+    return layers;
+}
+
+template <typename Scalar>
+void bind_sequential(py::module_& m, const char* name) {
+    using Model = BasicSequential<Scalar>;
+    using Matrix = typename Model::Matrix;
+    using Vector = typename Model::Vector;
+
+    py::class_<Model> cls(m, name);
+    cls.def(py::init([](const py::list& layers) { return Model(layers_from_python<Scalar>(layers)); }),
+            py::arg("layers"),
+            "Builds a network from a list like [(w1, b1), 'relu', (w2, b2), 'softmax'].")
+        .def(py::init([](const std::vector<Matrix>& weights, const std::vector<Vector>& biases,
+                         const std::string& activation, const std::string& output_activation) {
+                 return Model(weights, biases, parse_activation(activation), parse_activation(output_activation));
+             }),
+             py::arg("weights"), py::arg("biases"), py::arg("activation") = "relu",
+             py::arg("output_activation") = "identity",
+             "Builds a stack of dense layers from lists of weight and bias arrays.")
+        .def_property_readonly("input_size", &Model::input_size)
+        .def_property_readonly("output_size", &Model::output_size)
+        .def("describe", &Model::describe, "Returns the compiled execution plan.")
+        .def("save", [](const Model& self, const std::string& path) { save_model(path, self); },
+             py::arg("path"), "Writes the network to a model file that load_model() can memory-map.");
+    def_inference_methods<Model>(cls);
+}
+
+void require_same_size(Eigen::Index a, Eigen::Index b) {
+    if (a != b) {
+        throw std::invalid_argument("Arrays must be of the same size.");
+    }
+}
+
+// Binds math_lib's kernels for one dtype. Inputs are Eigen::Ref views of
+// contiguous 1-D arrays, so NumPy data is read in place; `out`/`y` must be
+// contiguous arrays of exactly this dtype and are written in place. Every
+// op also has a variant without `out` that returns a new array.
+template <typename Scalar>
+void bind_vector_kernels(py::module_& m) {
+    using Vector = Eigen::Matrix<Scalar, Eigen::Dynamic, 1>;
+    using In = const Eigen::Ref<const Vector>&;
+    using Out = Eigen::Ref<Vector>;
+    using Binary = void (*)(const Scalar*, const Scalar*, Scalar*, std::size_t);
+    const auto release = py::call_guard<py::gil_scoped_release>();
+    // float32 overloads only take float32 arrays as they are. Otherwise a
+    // float32 array passed with a Python int scalar would fail the exact
+    // match, then be converted to float64 by the float64 overload and come
+    // back as float64. Other inputs fall through to the float64 overloads,
+    // which convert them.
+    const auto input = [](const char* name) { return py::arg(name).noconvert(std::is_same_v<Scalar, float>); };
+
+    const auto def_binary = [&](const char* name, Binary kernel, const char* doc) {
+        m.def(name,
+              [kernel](In a, In b) {
+                  require_same_size(a.size(), b.size());
+                  Vector out(a.size());
+                  kernel(a.data(), b.data(), out.data(), out.size());
+                  return out;
+              },
+              input("a"), input("b"), release, doc);
+        m.def(name,
+              [kernel](In a, In b, Out out) {
+                  require_same_size(a.size(), b.size());
+                  require_same_size(a.size(), out.size());
+                  kernel(a.data(), b.data(), out.data(), out.size());
+              },
+              input("a"), input("b"), py::arg("out").noconvert(), release);
+    };
+    def_binary("add", &math_lib::add<Scalar>, "a + b");
+    def_binary("sub", &math_lib::sub<Scalar>, "a - b");
+    def_binary("mul", &math_lib::mul<Scalar>, "a * b");
+
+    m.def("scale",
+          [](In x, Scalar alpha) {
+              Vector out(x.size());
+              math_lib::scale(x.data(), alpha, out.data(), out.size());
+              return out;
+          },
+          input("x"), py::arg("alpha"), release, "alpha * x");
+    m.def("scale",
+          [](In x, Scalar alpha, Out out) {
+              require_same_size(x.size(), out.size());
+              math_lib::scale(x.data(), alpha, out.data(), out.size());
+          },
+          input("x"), py::arg("alpha"), py::arg("out").noconvert(), release);
+
+    m.def("fma",
+          [](In a, In b, In c) {
+              require_same_size(a.size(), b.size());
+              require_same_size(a.size(), c.size());
+              Vector out(a.size());
+              math_lib::fma(a.data(), b.data(), c.data(), out.data(), out.size());
+              return out;
+          },
+          input("a"), input("b"), input("c"), release, "a * b + c with a single rounding");
+    m.def("fma",
+          [](In a, In b, In c, Out out) {
+              require_same_size(a.size(), b.size());
+              require_same_size(a.size(), c.size());
+              require_same_size(a.size(), out.size());
+              math_lib::fma(a.data(), b.data(), c.data(), out.data(), out.size());
+          },
+          input("a"), input("b"), input("c"), py::arg("out").noconvert(), release);
+
+    m.def("axpy",
+          [](Scalar alpha, In x, Out y) {
+              require_same_size(x.size(), y.size());
+              math_lib::axpy(alpha, x.data(), y.data(), y.size());
+          },
+          py::arg("alpha"), input("x"), py::arg("y").noconvert(), release, "y += alpha * x, in place");
+
+    m.def("clamp",
+          [](In x, Scalar lo, Scalar hi) {
+              Vector out(x.size());
+              math_lib::clamp(x.data(), lo, hi, out.data(), out.size());
+              return out;
+          },
+          input("x"), py::arg("lo"), py::arg("hi"), release, "min(hi, max(lo, x)); NaNs are kept");
+    m.def("clamp",
+          [](In x, Scalar lo, Scalar hi, Out out) {
+              require_same_size(x.size(), out.size());
+              math_lib::clamp(x.data(), lo, hi, out.data(), out.size());
+          },
+          input("x"), py::arg("lo"), py::arg("hi"), py::arg("out").noconvert(), release);
+
+    // (x - mean) * inv_std in a single pass over x.
+    m.def("standardize",
+          [](In x, Scalar mean, Scalar inv_std) {
+              Vector out(x.size());
+              math_lib::evaluate(out.data(), (math_lib::vec(x.data(), x.size()) - mean) * inv_std);
+              return out;
+          },
+          input("x"), py::arg("mean"), py::arg("inv_std"), release, "(x - mean) * inv_std");
+    m.def("standardize",
+          [](In x, Scalar mean, Scalar inv_std, Out out) {
+              require_same_size(x.size(), out.size());
+              math_lib::evaluate(out.data(), (math_lib::vec(x.data(), x.size()) - mean) * inv_std);
+          },
+          input("x"), py::arg("mean"), py::arg("inv_std"), py::arg("out").noconvert(), release);
+
+    m.def("sum", [](In x) { return math_lib::sum(x.data(), x.size()); }, input("x"), release);
+    m.def("dot",
+          [](In a, In b) {
+              require_same_size(a.size(), b.size());
+              return math_lib::dot(a.data(), b.data(), a.size());
+          },
+          input("a"), input("b"), release);
+    m.def("norm", [](In x) { return math_lib::norm(x.data(), x.size()); }, input("x"), release,
+          "Euclidean norm");
+}
+
 PYBIND11_MODULE(cpp_math, m) {
-    m.doc() = "High-performance C++ module with an MLP class";
+    m.doc() = "High-performance C++ module with MLP and Sequential inference classes and vector kernels";
+
+    bind_mlp<double>(m, "MLP");
+    bind_mlp<float>(m, "MLPFloat32");
+    bind_sequential<double>(m, "Sequential");
+    bind_sequential<float>(m, "SequentialFloat32");
+
+    m.def("add_vectors", &add_vectors, py::arg("a"), py::arg("b"), "Adds two lists of floats element-wise.");
+
+    // float32 overloads are registered first and only accept float32 arrays,
+    // so those always run the float32 kernels; anything else is handled, and
+    // if needed converted, by the float64 overloads.
+    py::module_ vec = m.def_submodule("vec", "SIMD elementwise and reduction kernels on 1-D NumPy arrays");
+    bind_vector_kernels<float>(vec);
+    bind_vector_kernels<double>(vec);
+    vec.def("kernel_name", &math_lib::kernel_name, "The active kernel set: avx512, avx2 or scalar.");
+    vec.def("available_kernels", &math_lib::available_kernels);
+    vec.def("set_kernel", &math_lib::set_kernel, py::arg("name"),
+            "Selects a kernel set, e.g. 'scalar' to compare SIMD results against it.");
+
+    // Returns a Sequential or SequentialFloat32 (matching the file's dtype)
+    // whose weights point into the read-only mapping of `path`.
+    m.def("load_model",
+          [](const std::string& path, bool verify_checksum) -> py::object {
+              MappedModel model(path, verify_checksum);
+              if (model.dtype() == ModelDType::Float32) {
+                  return py::cast(model.network<float>());
+              }
+              return py::cast(model.network<double>());
+          },
+          py::arg("path"), py::arg("verify_checksum") = true,
+          "Memory-maps a model file written by Sequential.save().");
+
+    py::class_<InferenceFuture>(m, "InferenceFuture")
+        .def("done", &InferenceFuture::done)
+        .def("result", &InferenceFuture::result, py::arg("timeout") = py::none(),
+             "Blocks until the logits are ready and returns them.");
+
+    // Micro-batching server around a copy of an MLP. submit() only copies the
+    // input and enqueues it; the batching and GEMMs run on C++ worker threads.
+    py::class_<InferenceServer>(m, "InferenceServer")
+        .def(py::init([](const MLP& model, std::size_t workers, Eigen::Index max_batch_size,
+                         double max_delay_us, std::size_t queue_capacity, double submit_timeout_ms) {
+                 InferenceServerOptions options;
+                 options.worker_threads = workers;
+                 options.max_batch_size = max_batch_size;
+                 options.max_delay = std::chrono::microseconds(static_cast<std::int64_t>(max_delay_us));
+                 options.queue_capacity = queue_capacity;
+                 options.submit_timeout = std::chrono::milliseconds(static_cast<std::int64_t>(submit_timeout_ms));
+                 return std::make_unique<InferenceServer>(model, options);
+             }),
+             py::arg("model"), py::arg("workers") = 0, py::arg("max_batch_size") = 64,
+             py::arg("max_delay_us") = 200.0, py::arg("queue_capacity") = 4096,
+             py::arg("submit_timeout_ms") = 1000.0)
+        .def("submit",
+             [](InferenceServer& self, const Eigen::Ref<const Eigen::VectorXd>& input) {
+                 // Copy while the array is guarded by the GIL; submit() may
+                 // then sleep on a full queue without blocking Python.
+                 Eigen::VectorXd sample = input;
+                 py::gil_scoped_release release;
+                 return InferenceFuture{self.submit(std::move(sample)).share()};
+             },
+             py::arg("input"), "Queues one sample and returns an InferenceFuture.")
+        .def("predict",
+             [](InferenceServer& self, const Eigen::Ref<const Eigen::VectorXd>& input) {
+                 Eigen::VectorXd sample = input;
+                 py::gil_scoped_release release;
+                 return self.submit(std::move(sample)).get();
+             },
+             py::arg("input"), "Submits one sample and waits for its logits with the GIL released.")
+        .def("shutdown", &InferenceServer::shutdown, py::call_guard<py::gil_scoped_release>())
+        .def("stats", [](const InferenceServer& self) {
+            const InferenceServerStats stats = self.stats();
+            py::dict result;
+            result["requests"] = stats.requests;
+            result["batches"] = stats.batches;
+            result["mean_batch_size"] = stats.batches ? double(stats.requests) / double(stats.batches) : 0.0;
+            return result;
+        });
+
+    // Fixed-shape float32 MNIST model; layer widths are compile-time constants.
+    py::class_<FixedMnistMLP>(m, "FixedMLP784x128x10")
+        .def(py::init<const std::vector<Eigen::MatrixXf>&, const std::vector<Eigen::VectorXf>&>(),
+             py::arg("weights"), py::arg("biases"))
+        .def("predict", &FixedMnistMLP::predict, py::arg("input"))
+        .def("predict_batch",
+             py::overload_cast<const Eigen::Ref<const RowMatrixXf>&>(&FixedMnistMLP::predict_batch, py::const_),
+             py::arg("input"), py::call_guard<py::gil_scoped_release>())
+        .def("predict_batch",
+             py::overload_cast<const Eigen::Ref<const RowMatrixXf>&, Eigen::Ref<RowMatrixXf>>(&FixedMnistMLP::predict_batch, py::const_),
+             py::arg("input"), py::arg("out").noconvert(), py::call_guard<py::gil_scoped_release>());
 
-    // This defines a new class 'MLP' in our Python module
-    py::class_<MLP>(m, "MLP")
-        // This binds the C++ constructor. py::init<...>() specifies the argument types.
+    // The int8 model works on float32 activations; float64 input is converted.
+    py::class_<QuantizedMLP>(m, "MLPInt8")
         .def(py::init<const Eigen::MatrixXd&, const Eigen::VectorXd&,
                       const Eigen::MatrixXd&, const Eigen::VectorXd&>())
-        // This binds the 'predict' method.
-        .def("predict", &MLP::predict, "Performs a forward pass with the stored weights.");
+        .def("predict", &QuantizedMLP::predict, py::arg("input"),
+             "Performs a forward pass with int8 weights and activations.")
+        .def("predict_batch",
+             py::overload_cast<const Eigen::Ref<const RowMatrixXf>&>(&QuantizedMLP::predict_batch, py::const_),
+             py::arg("input"), py::call_guard<py::gil_scoped_release>())
+        .def("predict_batch",
+             py::overload_cast<const Eigen::Ref<const RowMatrixXf>&, Eigen::Ref<RowMatrixXf>>(&QuantizedMLP::predict_batch, py::const_),
+             py::arg("input"), py::arg("out").noconvert(), py::call_guard<py::gil_scoped_release>())
+        .def_property_readonly_static("kernel", [](py::object) { return QuantizedMLP::kernel_name(); },
+                                      "The int8 dot-product kernel selected for this CPU.")
+        .def_static("available_kernels", &QuantizedMLP::available_kernels,
+                    "int8 kernels this CPU can run, widest first.")
+        .def_static("set_kernel", &QuantizedMLP::set_kernel, py::arg("name"),
+                    "Switches every MLPInt8 to the named int8 kernel.");
 }
\ No newline at end of file
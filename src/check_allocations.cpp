@@ -0,0 +1,130 @@
+// Checks the allocation and thread-safety contracts of the single-sample
+// inference paths:
+//   - predict_into makes no heap allocations, with the model's own workspace
+//     or a caller-provided one;
+//   - once a thread's workspace fits the model, predict allocates only the
+//     vector it returns;
+//   - QuantizedMLP allocates only predict's result, and nothing in
+//     predict_batch with a given output;
+//   - threads calling predict on one shared model get the same results as a
+//     single thread.
+// Registered with ctest; exits non-zero on the first broken contract.
+
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "allocation_counter.h"
+#include "inference_lib.h"
+#include "quantized_mlp.h"
+#include "sequential.h"
+
+namespace {
+
+int g_failures = 0;
+
+void expect(bool condition, const std::string& what) {
+    if (!condition) {
+        std::cerr << "FAILED: " << what << "\n";
+        ++g_failures;
+    }
+}
+
+// Heap allocations made by `calls` invocations of `fn`, after one warm-up call.
+template <typename Fn>
+std::uint64_t allocations(Fn&& fn, int calls = 100) {
+    fn();
+    const std::uint64_t before = g_allocations.load(std::memory_order_relaxed);
+    for (int i = 0; i < calls; ++i) {
+        fn();
+    }
+    return g_allocations.load(std::memory_order_relaxed) - before;
+}
+
+// Every thread must reproduce the single-threaded result bit for bit.
+template <typename Model, typename Vector>
+void check_shared_predict(const Model& model, const Vector& input, const std::string& name) {
+    const Vector expected = model.predict(input);
+    std::atomic<int> mismatches{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&, t] {
+            const Vector other = Vector::Constant(model.input_size(), typename Vector::Scalar(t));
+            for (int i = 0; i < 500; ++i) {
+                // Interleave a different input so a shared workspace would be clobbered.
+                model.predict(other);
+                if (model.predict(input) != expected) {
+                    mismatches.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    expect(mismatches.load() == 0, name + ".predict is not thread-safe");
+}
+
+template <typename Model>
+void check_model(Model& model, const std::string& name) {
+    using Vector = typename Model::Vector;
+    const Vector input = Vector::Random(model.input_size());
+    Vector output(model.output_size());
+    auto workspace = model.make_workspace();
+
+    expect(allocations([&] { model.predict_into(input, output); }) == 0,
+           name + ".predict_into allocates");
+    expect(allocations([&] { model.predict_into(input, output, workspace); }) == 0,
+           name + ".predict_into(workspace) allocates");
+    expect(allocations([&] { output = model.predict(input); }, 100) <= 100,
+           name + ".predict allocates more than its result");
+    check_shared_predict(model, input, name);
+}
+
+// QuantizedMLP keeps its scratch per thread: after the first call, predict
+// allocates only its result and predict_batch into a given output nothing.
+void check_quantized(const QuantizedMLP& model) {
+    const Eigen::VectorXf input = Eigen::VectorXf::Random(model.input_size());
+    Eigen::VectorXf output(model.output_size());
+    const RowMatrixXf batch = RowMatrixXf::Random(67, model.input_size());
+    RowMatrixXf batch_output(batch.rows(), model.output_size());
+
+    expect(allocations([&] { output = model.predict(input); }, 100) <= 100,
+           "QuantizedMLP.predict allocates more than its result");
+    expect(allocations([&] { model.predict_batch(batch, batch_output); }) == 0,
+           "QuantizedMLP.predict_batch allocates");
+    check_shared_predict(model, input, "QuantizedMLP");
+}
+
+} // namespace
+
+int main() {
+    if (!kCountsAllocations) {
+        std::cout << "Allocation counting needs glibc; skipping.\n";
+        return 0;
+    }
+
+    MLP mlp(Eigen::MatrixXd::Random(784, 128), Eigen::VectorXd::Random(128),
+            Eigen::MatrixXd::Random(128, 10), Eigen::VectorXd::Random(10));
+    MLPf mlp_f(Eigen::MatrixXf::Random(784, 128), Eigen::VectorXf::Random(128),
+               Eigen::MatrixXf::Random(128, 10), Eigen::VectorXf::Random(10));
+    Sequential sequential({Layer::dense(Eigen::MatrixXd::Random(784, 256), Eigen::VectorXd::Random(256)),
+                           Layer::relu(),
+                           Layer::dense(Eigen::MatrixXd::Random(256, 64), Eigen::VectorXd::Random(64)),
+                           Layer::tanh(),
+                           Layer::dense(Eigen::MatrixXd::Random(64, 10), Eigen::VectorXd::Random(10))});
+
+    check_model(mlp, "MLP");
+    check_model(mlp_f, "MLPf");
+    check_model(sequential, "Sequential");
+    check_quantized(QuantizedMLP(Eigen::MatrixXd::Random(784, 128), Eigen::VectorXd::Random(128),
+                                 Eigen::MatrixXd::Random(128, 10), Eigen::VectorXd::Random(10)));
+
+    if (g_failures == 0) {
+        std::cout << "All allocation and thread-safety checks passed.\n";
+    }
+    return g_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,149 @@
+// Checks the latency histograms behind MLP::stats():
+//   - bucket_of/bucket_floor agree at the bucket edges and stay monotone;
+//   - counts, means, maxima and percentile order are right for a known set
+//     of samples, including samples recorded from several threads;
+//   - reset() and copies start from zero;
+//   - in profiling builds an MLP counts every call, and otherwise reports
+//     profiling as disabled.
+// Registered with ctest; exits non-zero on the first broken invariant.
+
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "inference_lib.h"
+#include "profiling.h"
+
+namespace {
+
+int g_failures = 0;
+
+void expect(bool condition, const std::string& what) {
+    if (!condition) {
+        std::cerr << "FAILED: " << what << "\n";
+        ++g_failures;
+    }
+}
+
+const ProfileStageStats& stage_stats(const ProfileStats& stats, ProfileStage stage) {
+    return stats.stages[static_cast<std::size_t>(stage)];
+}
+
+void check_buckets() {
+    const std::uint64_t saturation = std::uint64_t(1) << Profiler::kMaxBits;
+    for (std::uint64_t v : {std::uint64_t(0), std::uint64_t(1), std::uint64_t(7), std::uint64_t(8), std::uint64_t(9),
+                            std::uint64_t(15), std::uint64_t(16), std::uint64_t(17), std::uint64_t(1000),
+                            saturation - 1, saturation, saturation + 1, ~std::uint64_t(0)}) {
+        const std::size_t bucket = Profiler::bucket_of(v);
+        expect(bucket < Profiler::kBuckets, "bucket_of(" + std::to_string(v) + ") is out of range");
+        expect(Profiler::bucket_floor(bucket) <= v, "bucket_floor(bucket_of(" + std::to_string(v) + ")) > value");
+        if (v < saturation) {
+            expect(v < Profiler::bucket_floor(bucket + 1), "value " + std::to_string(v) + " is past its bucket");
+        } else {
+            expect(bucket == Profiler::kBuckets - 1, "value " + std::to_string(v) + " does not saturate");
+        }
+    }
+    // Exact below 2^kSubBucketBits, then a new bucket at every power of two.
+    expect(Profiler::bucket_of(7) == 7 && Profiler::bucket_of(8) == 8, "small values are not exact");
+    expect(Profiler::bucket_of(15) + 1 == Profiler::bucket_of(16), "no bucket starts at 16");
+    expect(Profiler::bucket_floor(Profiler::bucket_of(saturation - 1)) < saturation, "bucket below 2^40 is wrong");
+    std::size_t previous = 0;
+    for (std::uint64_t v = 0; v < (1u << 16); ++v) {
+        const std::size_t bucket = Profiler::bucket_of(v);
+        expect(bucket >= previous, "bucket_of is not monotone at " + std::to_string(v));
+        previous = bucket;
+    }
+}
+
+void check_histogram() {
+    Profiler profiler;
+    expect(profiler.stats().calls == 0 && stage_stats(profiler.stats(), ProfileStage::Total).count == 0,
+           "a new profiler is not empty");
+
+    // 1..1000 ns: mean 500.5, p50 ~ 500, p90 ~ 900, p99 ~ 990.
+    for (std::uint64_t ns = 1; ns <= 1000; ++ns) {
+        profiler.record(ProfileStage::Layer1, ns);
+    }
+    const ProfileStageStats layer1 = stage_stats(profiler.stats(), ProfileStage::Layer1);
+    expect(layer1.name == "layer1", "stage name");
+    expect(layer1.count == 1000, "layer1 count");
+    expect(layer1.mean_ns == 500.5 && layer1.max_ns == 1000, "layer1 mean/max");
+    expect(layer1.p50_ns <= layer1.p90_ns && layer1.p90_ns <= layer1.p99_ns && layer1.p99_ns <= layer1.max_ns,
+           "percentiles are out of order");
+    expect(std::abs(layer1.p50_ns - 500) <= 0.125 * 500, "p50 is off by more than 12.5%");
+    expect(std::abs(layer1.p90_ns - 900) <= 0.125 * 900, "p90 is off by more than 12.5%");
+    expect(std::abs(layer1.p99_ns - 990) <= 0.125 * 990, "p99 is off by more than 12.5%");
+    expect(stage_stats(profiler.stats(), ProfileStage::Layer2).count == 0, "unrecorded stage has samples");
+
+    // More threads than shards, so some shards are shared.
+    const int threads = 2 * static_cast<int>(Profiler::kShards);
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; ++t) {
+        pool.emplace_back([&profiler] {
+            for (int i = 0; i < 1000; ++i) {
+                profiler.count(2, 10, 1);
+                profiler.record(ProfileStage::Total, 5);
+            }
+        });
+    }
+    for (std::thread& thread : pool) {
+        thread.join();
+    }
+    const ProfileStats stats = profiler.stats();
+    const std::uint64_t calls = std::uint64_t(threads) * 1000;
+    expect(stats.calls == calls && stats.rows == 2 * calls && stats.bytes_in == 10 * calls && stats.bytes_out == calls,
+           "counters lost updates across threads");
+    expect(stage_stats(stats, ProfileStage::Total).count == calls, "histogram lost samples across threads");
+
+    Profiler copy = profiler;
+    expect(copy.stats().calls == 0, "a copy does not start empty");
+
+    profiler.reset();
+    const ProfileStats cleared = profiler.stats();
+    expect(cleared.calls == 0 && cleared.rows == 0 && cleared.bytes_in == 0 && cleared.bytes_out == 0,
+           "reset() left counters");
+    for (const ProfileStageStats& stage : cleared.stages) {
+        expect(stage.count == 0 && stage.max_ns == 0, "reset() left samples in " + stage.name);
+    }
+}
+
+void check_model() {
+    MLP model(Eigen::MatrixXd::Random(64, 32), Eigen::VectorXd::Random(32), Eigen::MatrixXd::Random(32, 4),
+              Eigen::VectorXd::Random(4));
+    const Eigen::VectorXd input = Eigen::VectorXd::Random(64);
+    Eigen::VectorXd output(4);
+    for (int i = 0; i < 100; ++i) {
+        model.predict_into(input, output);
+    }
+    const RowMatrixXf batch = RowMatrixXf::Random(300, 64);
+    RowMatrixXd batch_output(300, 4);
+    model.predict_batch(batch, batch_output);
+    const ProfileStats stats = model.stats();
+#ifdef INFERENCE_PROFILING
+    expect(stats.enabled, "profiling build reports stats as disabled");
+    expect(stats.calls == 101 && stats.rows == 400, "MLP did not count every call");
+    expect(stage_stats(stats, ProfileStage::Total).count == stats.calls, "total count differs from calls");
+    // 300 rows are three tiles.
+    expect(stage_stats(stats, ProfileStage::InputConversion).count == 3, "input conversion is not per tile");
+    expect(stage_stats(stats, ProfileStage::Layer1).count == 103, "layer1 count");
+    model.reset_stats();
+    expect(model.stats().calls == 0, "reset_stats() left counters");
+#else
+    expect(!stats.enabled && stats.calls == 0 && stats.stages.empty(), "disabled build recorded stats");
+#endif
+}
+
+} // namespace
+
+int main() {
+    check_buckets();
+    check_histogram();
+    check_model();
+    if (g_failures == 0) {
+        std::cout << "All profiling checks passed.\n";
+    }
+    return g_failures == 0 ? 0 : 1;
+}
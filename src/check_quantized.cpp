@@ -0,0 +1,162 @@
+// Checks the accuracy and kernel contracts of QuantizedMLP on a seeded random
+// network, without any external weights:
+//   - every logit is within the worst-case quantization error of the float64
+//     MLP, and at least 99% of the argmax labels agree with it;
+//   - every int8 kernel this CPU supports gives bit-identical results;
+//   - predict_batch matches predict row for row, whatever the batch size.
+// Registered with ctest; exits non-zero on the first broken contract.
+
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+#include "inference_lib.h"
+#include "quantized_mlp.h"
+
+namespace {
+
+int g_failures = 0;
+
+void expect(bool condition, const std::string& what) {
+    if (!condition) {
+        std::cerr << "FAILED: " << what << "\n";
+        ++g_failures;
+    }
+}
+
+Eigen::MatrixXd random_normal(Eigen::Index rows, Eigen::Index cols, double stddev, std::mt19937& rng) {
+    std::normal_distribution<double> dist(0.0, stddev);
+    return Eigen::MatrixXd::NullaryExpr(rows, cols, [&] { return dist(rng); });
+}
+
+// Worst-case |logit error| of QuantizedMLP against float64 for each sample
+// (row) and output. Rounding to the nearest int8 step is off by at most half a
+// step in both the weights (per output channel) and the activations (per
+// sample, per layer). Layer 1's error passes through ReLU unchanged in size
+// and adds to the rounding of the hidden activations. The 1% and 1e-4 margins
+// cover float32 arithmetic. benchmark.py applies the same bound to real
+// weights.
+RowMatrixXd int8_error_bound(const RowMatrixXd& x, const Eigen::MatrixXd& w1, const Eigen::VectorXd& b1,
+                             const Eigen::MatrixXd& w2) {
+    const Eigen::RowVectorXd w1_step = w1.cwiseAbs().colwise().maxCoeff() / 127.0;
+    const Eigen::RowVectorXd w2_step = w2.cwiseAbs().colwise().maxCoeff() / 127.0;
+    const Eigen::RowVectorXd w1_abs_sum = (w1.cwiseAbs().rowwise() + w1_step / 2.0).colwise().sum();
+    const Eigen::MatrixXd w2_abs = w2.cwiseAbs().rowwise() + w2_step / 2.0;
+
+    RowMatrixXd bound(x.rows(), w2.cols());
+    for (Eigen::Index r = 0; r < x.rows(); ++r) {
+        const double x_step = x.row(r).cwiseAbs().maxCoeff() / 127.0;
+        const Eigen::RowVectorXd hidden = (x.row(r) * w1 + b1.transpose()).cwiseMax(0.0);
+        const Eigen::RowVectorXd hidden_error = x.row(r).cwiseAbs().sum() * w1_step / 2.0 + x_step / 2.0 * w1_abs_sum;
+        const double hidden_step = (hidden + hidden_error).maxCoeff() / 127.0;
+        const Eigen::RowVectorXd input_error = hidden_error.array() + hidden_step / 2.0;
+        bound.row(r) = hidden.sum() * w2_step / 2.0 + input_error * w2_abs;
+    }
+    return bound * 1.01 + RowMatrixXd::Constant(x.rows(), w2.cols(), 1e-4);
+}
+
+Eigen::Index argmax(const Eigen::Ref<const Eigen::RowVectorXd>& row) {
+    Eigen::Index index;
+    row.maxCoeff(&index);
+    return index;
+}
+
+// Rows of noisy copies of `prototypes.rows()` class prototypes, in [0, 1]
+// like normalized pixels; sample r belongs to class r % prototypes.rows().
+RowMatrixXd noisy_samples(const RowMatrixXd& prototypes, Eigen::Index rows, std::mt19937& rng) {
+    std::uniform_real_distribution<double> noise(0.0, 1.0);
+    RowMatrixXd samples(rows, prototypes.cols());
+    for (Eigen::Index r = 0; r < rows; ++r) {
+        for (Eigen::Index c = 0; c < prototypes.cols(); ++c) {
+            samples(r, c) = 0.6 * prototypes(r % prototypes.rows(), c) + 0.4 * noise(rng);
+        }
+    }
+    return samples;
+}
+
+} // namespace
+
+int main() {
+    const Eigen::Index inputs = 784, hidden = 128, outputs = 10;
+    std::mt19937 rng(42);
+
+    // The argmax check is only meaningful for a confident classifier, so the
+    // output layer is fitted by least squares to one-hot labels of clustered
+    // data rather than drawn at random; random logits are often near-ties.
+    std::uniform_real_distribution<double> pixel(0.0, 1.0);
+    const RowMatrixXd prototypes = RowMatrixXd::NullaryExpr(outputs, inputs, [&] { return pixel(rng); });
+    const Eigen::MatrixXd w1 = random_normal(inputs, hidden, std::sqrt(2.0 / inputs), rng);
+    const Eigen::VectorXd b1 = random_normal(hidden, 1, 0.1, rng);
+    const RowMatrixXd train = noisy_samples(prototypes, 1000, rng);
+    const Eigen::MatrixXd features = (train * w1).rowwise() + b1.transpose();
+    const Eigen::MatrixXd activations = features.cwiseMax(0.0);
+    Eigen::MatrixXd labels = Eigen::MatrixXd::Zero(train.rows(), outputs);
+    for (Eigen::Index r = 0; r < train.rows(); ++r) {
+        labels(r, r % outputs) = 1.0;
+    }
+    const Eigen::MatrixXd gram = activations.transpose() * activations + 1e-3 * Eigen::MatrixXd::Identity(hidden, hidden);
+    const Eigen::MatrixXd w2 = gram.ldlt().solve(activations.transpose() * labels);
+    const Eigen::VectorXd b2 = random_normal(outputs, 1, 0.01, rng);
+    const MLP reference_model(w1, b1, w2, b2);
+    const QuantizedMLP model(w1, b1, w2, b2);
+
+    // An odd row count leaves a tail after the last block of kRowBlock rows.
+    const RowMatrixXd batch = noisy_samples(prototypes, 2003, rng);
+    const RowMatrixXf batch_f = batch.cast<float>();
+    const RowMatrixXd reference = reference_model.predict_batch(batch);
+
+    const std::string default_kernel = QuantizedMLP::kernel_name();
+    const RowMatrixXf logits = model.predict_batch(batch_f);
+    const RowMatrixXd error = (logits.cast<double>() - reference).cwiseAbs();
+    const RowMatrixXd bound = int8_error_bound(batch, w1, b1, w2);
+    expect((error.array() <= bound.array()).all(),
+           "int8 error exceeds the quantization bound (worst error / bound " +
+               std::to_string((error.array() / bound.array()).maxCoeff()) + ")");
+
+    Eigen::Index agreeing = 0;
+    for (Eigen::Index r = 0; r < batch.rows(); ++r) {
+        agreeing += argmax(logits.row(r).cast<double>()) == argmax(reference.row(r));
+    }
+    const double agreement = double(agreeing) / double(batch.rows());
+    expect(agreement >= 0.99, "int8 argmax agreement " + std::to_string(agreement) + " is below 0.99");
+
+    // int32 accumulation is exact, so every kernel must reproduce the scalar
+    // result bit for bit, in blocks and one row at a time.
+    QuantizedMLP::set_kernel("scalar");
+    const RowMatrixXf expected = model.predict_batch(batch_f);
+    for (const std::string& kernel : QuantizedMLP::available_kernels()) {
+        QuantizedMLP::set_kernel(kernel);
+        expect(model.predict_batch(batch_f) == expected, kernel + " predict_batch differs from scalar");
+        for (Eigen::Index rows : {1, 2, 3, 5, 9}) {
+            expect(model.predict_batch(batch_f.topRows(rows)) == expected.topRows(rows),
+                   kernel + " predict_batch of " + std::to_string(rows) + " rows differs from scalar");
+        }
+        bool rows_match = true;
+        for (Eigen::Index r = 0; r < 64; ++r) {
+            rows_match = rows_match && model.predict(batch_f.row(r).transpose()) == expected.row(r).transpose();
+        }
+        expect(rows_match, kernel + " predict differs from predict_batch");
+    }
+    QuantizedMLP::set_kernel(default_kernel);
+
+    bool rejected = false;
+    try {
+        QuantizedMLP::set_kernel("no-such-kernel");
+    } catch (const std::invalid_argument&) {
+        rejected = true;
+    }
+    expect(rejected, "set_kernel accepts an unknown kernel");
+    expect(QuantizedMLP::kernel_name() == default_kernel, "a rejected set_kernel changed the kernel");
+
+    if (g_failures == 0) {
+        std::cout << "int8 within its quantization bound (argmax agreement " << agreement * 100
+                  << "%); kernels";
+        for (const std::string& kernel : QuantizedMLP::available_kernels()) {
+            std::cout << " " << kernel;
+        }
+        std::cout << " match exactly.\n";
+    }
+    return g_failures == 0 ? 0 : 1;
+}
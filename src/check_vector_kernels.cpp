@@ -0,0 +1,192 @@
+// Checks the kernel contract of math_lib on seeded random data:
+//   - every kernel set this CPU supports gives bit-identical results to the
+//     scalar set, for every op, in float64 and float32, over empty arrays,
+//     every tail length and misaligned views, with a NaN in the input;
+//   - the scalar elementwise ops round exactly like plain C++ arithmetic.
+// Registered with ctest; exits non-zero on the first broken contract.
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "math_lib.h"
+#include "vector_expr.h"
+
+namespace {
+
+int g_failures = 0;
+
+void expect(bool condition, const std::string& what) {
+    if (!condition) {
+        std::cerr << "FAILED: " << what << "\n";
+        ++g_failures;
+    }
+}
+
+const char* const kOpNames[] = {
+    "add", "sub", "mul", "add_scalar", "scale", "fma", "axpy", "clamp", "standardize",
+    "in-place add", "in-place sub", "in-place mul", "in-place scale", "in-place clamp", "sum/dot/norm",
+};
+
+// Inputs of `n` elements starting `offset` elements into their allocation, so
+// that the kernels see misaligned data.
+template <typename T>
+struct Operands {
+    std::vector<T> a, b, c;
+    std::size_t offset;
+
+    const T* pa() const { return a.data() + offset; }
+    const T* pb() const { return b.data() + offset; }
+    const T* pc() const { return c.data() + offset; }
+};
+
+// Runs every op on the operands with the active kernel set. Result i is the
+// output of kOpNames[i]; outputs share the inputs' misalignment.
+template <typename T>
+std::vector<std::vector<T>> run_ops(const Operands<T>& x, std::size_t n) {
+    const std::size_t offset = x.offset;
+    std::vector<std::vector<T>> results;
+    auto output = [&]() -> T* {
+        results.emplace_back(n + offset, T(0));
+        return results.back().data() + offset;
+    };
+    auto copy_of = [&](const T* source) -> T* {
+        results.emplace_back(n + offset, T(0));
+        std::copy(source, source + n, results.back().data() + offset);
+        return results.back().data() + offset;
+    };
+
+    math_lib::add(x.pa(), x.pb(), output(), n);
+    math_lib::sub(x.pa(), x.pb(), output(), n);
+    math_lib::mul(x.pa(), x.pb(), output(), n);
+    math_lib::add_scalar(x.pa(), T(0.375), output(), n);
+    math_lib::scale(x.pa(), T(-1.5), output(), n);
+    math_lib::fma(x.pa(), x.pb(), x.pc(), output(), n);
+    math_lib::axpy(T(0.75), x.pa(), copy_of(x.pb()), n);
+    math_lib::clamp(x.pa(), T(-0.5), T(0.5), output(), n);
+    math_lib::evaluate(output(), (math_lib::vec(x.pa(), n) - T(0.25)) * T(4));
+    math_lib::add(copy_of(x.pa()), x.pb(), n);
+    math_lib::sub(copy_of(x.pa()), x.pb(), n);
+    math_lib::mul(copy_of(x.pa()), x.pb(), n);
+    math_lib::scale(copy_of(x.pa()), T(-1.5), n);
+    math_lib::clamp(copy_of(x.pa()), T(-0.5), T(0.5), n);
+    results.push_back({math_lib::sum(x.pa(), n), math_lib::dot(x.pa(), x.pb(), n), math_lib::norm(x.pa(), n)});
+    return results;
+}
+
+// memcmp rather than ==, so that NaNs compare equal to themselves.
+template <typename T>
+bool same_bits(const std::vector<T>& x, const std::vector<T>& y) {
+    return x.size() == y.size() && std::memcmp(x.data(), y.data(), x.size() * sizeof(T)) == 0;
+}
+
+template <typename T>
+void check_kernel_parity(const std::string& type, std::mt19937& rng) {
+    std::normal_distribution<T> normal(T(0), T(1));
+    std::vector<std::size_t> sizes;
+    for (std::size_t n = 0; n < 70; ++n) {
+        sizes.push_back(n);
+    }
+    sizes.insert(sizes.end(), {255, 1000, 4099});
+
+    for (std::size_t n : sizes) {
+        for (std::size_t offset : {0, 1, 3}) {
+            Operands<T> x{{}, {}, {}, offset};
+            for (std::vector<T>* v : {&x.a, &x.b, &x.c}) {
+                v->resize(n + offset);
+                for (T& value : *v) {
+                    value = normal(rng);
+                }
+            }
+            if (n > 2) {
+                x.a[offset + 1] = std::numeric_limits<T>::quiet_NaN();
+            }
+
+            math_lib::set_kernel("scalar");
+            const std::vector<std::vector<T>> expected = run_ops(x, n);
+            for (const std::string& kernel : math_lib::available_kernels()) {
+                math_lib::set_kernel(kernel);
+                const std::vector<std::vector<T>> got = run_ops(x, n);
+                for (std::size_t op = 0; op < expected.size(); ++op) {
+                    expect(same_bits(got[op], expected[op]),
+                           kernel + " " + kOpNames[op] + " differs from scalar (" + type + ", n=" +
+                               std::to_string(n) + ", offset=" + std::to_string(offset) + ")");
+                }
+            }
+        }
+    }
+}
+
+// The scalar set is the reference for the others, so it must itself round
+// like one C++ operation per element.
+template <typename T>
+void check_scalar_rounding(const std::string& type, std::mt19937& rng) {
+    std::normal_distribution<T> normal(T(0), T(1));
+    const std::size_t n = 1000;
+    std::vector<T> a(n), b(n), c(n), out(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        a[i] = normal(rng);
+        b[i] = normal(rng);
+        c[i] = normal(rng);
+    }
+
+    math_lib::set_kernel("scalar");
+    bool add_ok = true, mul_ok = true, fma_ok = true, clamp_ok = true;
+    math_lib::add(a.data(), b.data(), out.data(), n);
+    for (std::size_t i = 0; i < n; ++i) {
+        add_ok = add_ok && out[i] == a[i] + b[i];
+    }
+    math_lib::mul(a.data(), b.data(), out.data(), n);
+    for (std::size_t i = 0; i < n; ++i) {
+        mul_ok = mul_ok && out[i] == a[i] * b[i];
+    }
+    math_lib::fma(a.data(), b.data(), c.data(), out.data(), n);
+    for (std::size_t i = 0; i < n; ++i) {
+        fma_ok = fma_ok && out[i] == std::fma(a[i], b[i], c[i]);
+    }
+    math_lib::clamp(a.data(), T(-0.5), T(0.5), out.data(), n);
+    for (std::size_t i = 0; i < n; ++i) {
+        clamp_ok = clamp_ok && out[i] == std::min(T(0.5), std::max(T(-0.5), a[i]));
+    }
+    expect(add_ok, "scalar add does not round like a + b (" + type + ")");
+    expect(mul_ok, "scalar mul does not round like a * b (" + type + ")");
+    expect(fma_ok, "scalar fma does not round like std::fma (" + type + ")");
+    expect(clamp_ok, "scalar clamp does not match min/max (" + type + ")");
+}
+
+} // namespace
+
+int main() {
+    std::mt19937 rng(42);
+    const std::string default_kernel = math_lib::kernel_name();
+
+    check_kernel_parity<double>("float64", rng);
+    check_kernel_parity<float>("float32", rng);
+    check_scalar_rounding<double>("float64", rng);
+    check_scalar_rounding<float>("float32", rng);
+    math_lib::set_kernel(default_kernel);
+
+    bool rejected = false;
+    try {
+        math_lib::set_kernel("no-such-kernel");
+    } catch (const std::invalid_argument&) {
+        rejected = true;
+    }
+    expect(rejected, "set_kernel accepts an unknown kernel");
+    expect(math_lib::kernel_name() == default_kernel, "a rejected set_kernel changed the kernel");
+
+    if (g_failures == 0) {
+        std::cout << "Kernels";
+        for (const std::string& kernel : math_lib::available_kernels()) {
+            std::cout << " " << kernel;
+        }
+        std::cout << " match exactly (73 sizes x 3 offsets x 2 dtypes).\n";
+    }
+    return g_failures == 0 ? 0 : 1;
+}
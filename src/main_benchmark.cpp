@@ -0,0 +1,604 @@
+// Native benchmark suite for inference_lib and math_lib.
+//
+// Every case runs on synthetic weights, so no model files are needed. For
+// each case the suite reports min/median/p99 time per call, throughput,
+// GFLOP/s where the FLOP count is known, heap allocations per call and, when
+// the kernel allows perf_event_open, cycles/instructions/cache misses per
+// call. The counters measure the calling thread only. Use --json to write the
+// results for diffing between releases.
+//
+// Usage: cpp_benchmark [--json PATH] [--filter SUBSTRING] [--samples N]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "allocation_counter.h"
+#include "fixed_sequential.h"
+#include "inference_lib.h"
+#include "math_lib.h"
+#include "quantized_mlp.h"
+#include "sequential.h"
+#include "vector_expr.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#ifdef INFERENCE_PROFILING
+constexpr bool kProfiling = true;
+#else
+constexpr bool kProfiling = false;
+#endif
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Keeps results of reductions alive so the compiler cannot drop the call.
+volatile float benchmark_sink = 0;
+
+// --- Hardware counters ---
+struct CounterValues {
+    bool valid = false;
+    double cycles = 0;
+    double instructions = 0;
+    double cache_misses = 0;
+};
+
+// Cycles, instructions and last-level cache misses of the calling thread
+// only, read as one perf_event group. In multi-threaded cases they cover
+// thread 0's share of the work, not the other workers. Unavailable (and
+// silently disabled) when the kernel or container forbids perf_event_open.
+class PerfCounters {
+public:
+    PerfCounters() {
+#ifdef __linux__
+        const std::uint64_t configs[] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+                                         PERF_COUNT_HW_CACHE_MISSES};
+        for (std::uint64_t config : configs) {
+            perf_event_attr attr{};
+            attr.size = sizeof(attr);
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = config;
+            attr.disabled = m_fds.empty() ? 1 : 0;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_GROUP;
+            const int group = m_fds.empty() ? -1 : m_fds.front();
+            const int fd = static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, group, 0));
+            if (fd < 0) {
+                close_all();
+                return;
+            }
+            m_fds.push_back(fd);
+        }
+#endif
+    }
+
+    ~PerfCounters() { close_all(); }
+
+    bool available() const { return !m_fds.empty(); }
+
+    void start() {
+#ifdef __linux__
+        if (available()) {
+            ::ioctl(m_fds.front(), PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+            ::ioctl(m_fds.front(), PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        }
+#endif
+    }
+
+    CounterValues stop(std::uint64_t calls) {
+        CounterValues values;
+#ifdef __linux__
+        if (available()) {
+            ::ioctl(m_fds.front(), PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+            std::uint64_t data[4] = {};
+            if (::read(m_fds.front(), data, sizeof(data)) == static_cast<ssize_t>(sizeof(data)) && data[0] == 3) {
+                values.valid = true;
+                values.cycles = double(data[1]) / double(calls);
+                values.instructions = double(data[2]) / double(calls);
+                values.cache_misses = double(data[3]) / double(calls);
+            }
+        }
+#else
+        (void)calls;
+#endif
+        return values;
+    }
+
+private:
+    void close_all() {
+#ifdef __linux__
+        for (int fd : m_fds) {
+            ::close(fd);
+        }
+#endif
+        m_fds.clear();
+    }
+
+    std::vector<int> m_fds;
+};
+
+// --- Measurement ---
+struct Result {
+    std::string name;
+    std::map<std::string, long long> params;
+    std::uint64_t samples = 0;
+    std::uint64_t calls_per_sample = 0;
+    double min_ns = 0;
+    double median_ns = 0;
+    double p99_ns = 0;
+    double mean_ns = 0;
+    double items_per_call = 0;   // samples/elements processed per call
+    double flops_per_call = 0;   // 0 when not meaningful
+    double bytes_per_call = 0;   // memory traffic estimate, 0 when not meaningful
+    double allocs_per_call = 0;
+    CounterValues counters;
+};
+
+struct Options {
+    std::string json_path;
+    std::string filter;
+    std::uint64_t samples = 200;
+};
+
+double percentile(std::vector<double> sorted, double p) {
+    const std::size_t index = std::min(sorted.size() - 1, static_cast<std::size_t>(p * double(sorted.size() - 1) + 0.5));
+    return sorted[index];
+}
+
+// Times `fn`. Calls are grouped so that each sample lasts at least ~20 us
+// (timer resolution stays negligible) and the whole case takes ~0.25 s at
+// most, with at least 10 samples.
+Result measure(const Options& options, const std::function<void()>& fn) {
+    fn(); // warm up caches and lazily sized buffers
+
+    const auto probe_start = Clock::now();
+    fn();
+    const double probe_ns = std::max(1.0, double(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - probe_start).count()));
+
+    Result result;
+    result.calls_per_sample = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(20'000.0 / probe_ns));
+    const double sample_ns = probe_ns * double(result.calls_per_sample);
+    result.samples = std::max<std::uint64_t>(10, std::min<std::uint64_t>(options.samples, static_cast<std::uint64_t>(250e6 / sample_ns)));
+
+    std::vector<double> times;
+    times.reserve(result.samples);
+
+    PerfCounters counters;
+    const std::uint64_t allocations_before = g_allocations.load(std::memory_order_relaxed);
+    counters.start();
+    for (std::uint64_t s = 0; s < result.samples; ++s) {
+        const auto start = Clock::now();
+        for (std::uint64_t c = 0; c < result.calls_per_sample; ++c) {
+            fn();
+        }
+        const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+        times.push_back(double(elapsed) / double(result.calls_per_sample));
+    }
+    const std::uint64_t total_calls = result.samples * result.calls_per_sample;
+    result.counters = counters.stop(total_calls);
+    result.allocs_per_call = double(g_allocations.load(std::memory_order_relaxed) - allocations_before) / double(total_calls);
+
+    std::sort(times.begin(), times.end());
+    result.min_ns = times.front();
+    result.median_ns = percentile(times, 0.5);
+    result.p99_ns = percentile(times, 0.99);
+    double total = 0;
+    for (double t : times) {
+        total += t;
+    }
+    result.mean_ns = total / double(times.size());
+    return result;
+}
+
+// Runs `fn(thread_index)` on `threads` threads at once. The workers start
+// once, outside the timed region, and wait between rounds, so a timed call of
+// run() covers only the work and the hand-off, not thread creation. The
+// calling thread is thread 0.
+class ParallelRounds {
+public:
+    ParallelRounds(int threads, std::function<void(int)> fn) : m_fn(std::move(fn)) {
+        m_workers.reserve(threads - 1);
+        for (int t = 1; t < threads; ++t) {
+            m_workers.emplace_back([this, t] { work(t); });
+        }
+    }
+
+    ~ParallelRounds() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_start.notify_all();
+        for (std::thread& worker : m_workers) {
+            worker.join();
+        }
+    }
+
+    ParallelRounds(const ParallelRounds&) = delete;
+    ParallelRounds& operator=(const ParallelRounds&) = delete;
+
+    // One round across all threads; returns when every thread has finished.
+    void run() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_pending = static_cast<int>(m_workers.size());
+            ++m_round;
+        }
+        m_start.notify_all();
+        m_fn(0);
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_done.wait(lock, [this] { return m_pending == 0; });
+    }
+
+private:
+    void work(int index) {
+        std::uint64_t seen = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_start.wait(lock, [&] { return m_stop || m_round != seen; });
+                if (m_stop) {
+                    return;
+                }
+                seen = m_round;
+            }
+            m_fn(index);
+            bool last;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                last = --m_pending == 0;
+            }
+            if (last) {
+                m_done.notify_one();
+            }
+        }
+    }
+
+    std::function<void(int)> m_fn;
+    std::mutex m_mutex;
+    std::condition_variable m_start;
+    std::condition_variable m_done;
+    std::uint64_t m_round = 0;
+    int m_pending = 0;
+    bool m_stop = false;
+    std::vector<std::thread> m_workers;
+};
+
+// --- Synthetic models ---
+double mlp_flops(Eigen::Index inputs, Eigen::Index hidden, Eigen::Index outputs) {
+    return 2.0 * double(inputs * hidden + hidden * outputs);
+}
+
+MLP make_mlp(Eigen::Index inputs, Eigen::Index hidden, Eigen::Index outputs) {
+    return MLP(Eigen::MatrixXd::Random(inputs, hidden), Eigen::VectorXd::Random(hidden),
+               Eigen::MatrixXd::Random(hidden, outputs), Eigen::VectorXd::Random(outputs));
+}
+
+// --- Reporting ---
+std::string format_params(const Result& result) {
+    std::ostringstream out;
+    bool first = true;
+    for (const auto& [key, value] : result.params) {
+        out << (first ? "" : " ") << key << "=" << value;
+        first = false;
+    }
+    return out.str();
+}
+
+void print_header() {
+    std::cout << std::left << std::setw(26) << "benchmark" << std::setw(40) << "params" << std::right
+              << std::setw(12) << "min_us" << std::setw(12) << "median_us" << std::setw(12) << "p99_us"
+              << std::setw(14) << "items/s" << std::setw(10) << "GFLOP/s" << std::setw(10) << "allocs"
+              << std::setw(12) << "cycles" << std::setw(12) << "llc_miss" << "\n";
+}
+
+void print_result(const Result& r) {
+    const double items_per_second = r.items_per_call * 1e9 / r.median_ns;
+    std::cout << std::left << std::setw(26) << r.name << std::setw(40) << format_params(r) << std::right
+              << std::fixed << std::setprecision(3) << std::setw(12) << r.min_ns / 1e3 << std::setw(12)
+              << r.median_ns / 1e3 << std::setw(12) << r.p99_ns / 1e3 << std::setprecision(0) << std::setw(14)
+              << items_per_second << std::setprecision(2) << std::setw(10)
+              << (r.flops_per_call > 0 ? r.flops_per_call / r.median_ns : 0.0) << std::setw(10) << r.allocs_per_call;
+    if (r.counters.valid) {
+        std::cout << std::setprecision(0) << std::setw(12) << r.counters.cycles << std::setw(12) << r.counters.cache_misses;
+    } else {
+        std::cout << std::setw(12) << "-" << std::setw(12) << "-";
+    }
+    std::cout << "\n";
+}
+
+void write_json(const std::string& path, const std::vector<Result>& results, bool counters_available) {
+    std::ofstream out(path);
+    out << std::setprecision(10);
+    out << "{\n  \"context\": {\n";
+    out << "    \"compiler\": \"" << __VERSION__ << "\",\n";
+#ifdef NDEBUG
+    out << "    \"assertions\": false,\n";
+#else
+    out << "    \"assertions\": true,\n";
+#endif
+    out << "    \"hardware_threads\": " << std::thread::hardware_concurrency() << ",\n";
+    out << "    \"int8_kernel\": \"" << QuantizedMLP::kernel_name() << "\",\n";
+    out << "    \"counts_allocations\": " << (kCountsAllocations ? "true" : "false") << ",\n";
+    out << "    \"profiling\": " << (kProfiling ? "true" : "false") << ",\n";
+    out << "    \"perf_counters\": " << (counters_available ? "true" : "false") << ",\n";
+    out << "    \"timestamp\": " << std::chrono::duration_cast<std::chrono::seconds>(
+                                         std::chrono::system_clock::now().time_since_epoch()).count() << "\n";
+    out << "  },\n  \"benchmarks\": [\n";
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        out << "    {\"name\": \"" << r.name << "\", \"params\": {";
+        bool first = true;
+        for (const auto& [key, value] : r.params) {
+            out << (first ? "" : ", ") << "\"" << key << "\": " << value;
+            first = false;
+        }
+        out << "}, \"samples\": " << r.samples << ", \"calls_per_sample\": " << r.calls_per_sample
+            << ", \"min_ns\": " << r.min_ns << ", \"median_ns\": " << r.median_ns << ", \"p99_ns\": " << r.p99_ns
+            << ", \"mean_ns\": " << r.mean_ns << ", \"items_per_second\": " << r.items_per_call * 1e9 / r.median_ns
+            << ", \"gflops\": " << (r.flops_per_call > 0 ? r.flops_per_call / r.median_ns : 0.0)
+            << ", \"bytes_per_second\": " << r.bytes_per_call * 1e9 / r.median_ns
+            << ", \"allocs_per_call\": " << r.allocs_per_call << ", \"counters\": ";
+        if (r.counters.valid) {
+            out << "{\"cycles\": " << r.counters.cycles << ", \"instructions\": " << r.counters.instructions
+                << ", \"cache_misses\": " << r.counters.cache_misses << "}";
+        } else {
+            out << "null";
+        }
+        out << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+}
+
+// --- Benchmark cases ---
+class Suite {
+public:
+    explicit Suite(Options options) : m_options(std::move(options)) {}
+
+    // Registers and immediately runs one case unless it is filtered out.
+    void run(const std::string& name, std::map<std::string, long long> params, double items_per_call,
+             double flops_per_call, double bytes_per_call, const std::function<void()>& fn) {
+        Result probe;
+        probe.name = name;
+        probe.params = params;
+        const std::string label = name + " " + format_params(probe);
+        if (!m_options.filter.empty() && label.find(m_options.filter) == std::string::npos) {
+            return;
+        }
+        Result result = measure(m_options, fn);
+        result.name = name;
+        result.params = std::move(params);
+        result.items_per_call = items_per_call;
+        result.flops_per_call = flops_per_call;
+        result.bytes_per_call = bytes_per_call;
+        print_result(result);
+        m_results.push_back(std::move(result));
+    }
+
+    const std::vector<Result>& results() const { return m_results; }
+    const Options& options() const { return m_options; }
+
+private:
+    Options m_options;
+    std::vector<Result> m_results;
+};
+
+void bench_mlp_single(Suite& suite) {
+    const Eigen::Index outputs = 10;
+    for (Eigen::Index inputs : {256, 784, 2048}) {
+        for (Eigen::Index hidden : {64, 128, 512}) {
+            MLP model = make_mlp(inputs, hidden, outputs);
+            MLP::Workspace workspace = model.make_workspace();
+            const Eigen::VectorXd input = Eigen::VectorXd::Random(inputs);
+            Eigen::VectorXd output(outputs);
+            const std::map<std::string, long long> params = {{"inputs", inputs}, {"hidden", hidden}};
+            const double flops = mlp_flops(inputs, hidden, outputs);
+
+            suite.run("mlp.predict", params, 1, flops, 0, [&] { output = model.predict(input); });
+            suite.run("mlp.predict_into", params, 1, flops, 0, [&] { model.predict_into(input, output, workspace); });
+        }
+    }
+}
+
+void bench_mlp_batch(Suite& suite) {
+    const Eigen::Index inputs = 784, hidden = 128, outputs = 10;
+    MLP model = make_mlp(inputs, hidden, outputs);
+    MLPf model_f(Eigen::MatrixXf::Random(inputs, hidden), Eigen::VectorXf::Random(hidden),
+                 Eigen::MatrixXf::Random(hidden, outputs), Eigen::VectorXf::Random(outputs));
+    QuantizedMLP model_q(Eigen::MatrixXd::Random(inputs, hidden), Eigen::VectorXd::Random(hidden),
+                         Eigen::MatrixXd::Random(hidden, outputs), Eigen::VectorXd::Random(outputs));
+    FixedMnistMLP model_fixed({Eigen::MatrixXf::Random(inputs, hidden), Eigen::MatrixXf::Random(hidden, outputs)},
+                              {Eigen::VectorXf::Random(hidden), Eigen::VectorXf::Random(outputs)});
+
+    for (Eigen::Index batch : {1, 16, 128, 1024, 8192}) {
+        const RowMatrixXd input = RowMatrixXd::Random(batch, inputs);
+        const RowMatrixXf input_f = input.cast<float>();
+        RowMatrixXd output(batch, outputs);
+        RowMatrixXf output_f(batch, outputs);
+        const std::map<std::string, long long> params = {{"batch", batch}};
+        const double flops = mlp_flops(inputs, hidden, outputs) * double(batch);
+
+        suite.run("mlp.predict_batch", params, double(batch), flops, 0, [&] { model.predict_batch(input, output); });
+        suite.run("mlpf.predict_batch", params, double(batch), flops, 0, [&] { model_f.predict_batch(input_f, output_f); });
+        suite.run("mlp_int8.predict_batch", params, double(batch), flops, 0, [&] { model_q.predict_batch(input_f, output_f); });
+        suite.run("fixed.predict_batch", params, double(batch), flops, 0, [&] { model_fixed.predict_batch(input_f, output_f); });
+    }
+}
+
+// The standalone forward_pass() the executables used to call no longer
+// exists; Sequential is the general forward pass behind main_inference.
+void bench_sequential(Suite& suite) {
+    const Eigen::Index inputs = 784, outputs = 10;
+    for (int depth : {2, 4, 6}) {
+        std::vector<Eigen::MatrixXd> weights;
+        std::vector<Eigen::VectorXd> biases;
+        double flops = 0;
+        Eigen::Index width = inputs;
+        for (int l = 0; l < depth; ++l) {
+            const Eigen::Index next = l + 1 == depth ? outputs : 128;
+            weights.push_back(Eigen::MatrixXd::Random(width, next));
+            biases.push_back(Eigen::VectorXd::Random(next));
+            flops += 2.0 * double(width * next);
+            width = next;
+        }
+        Sequential network(weights, biases);
+        Sequential::Workspace workspace = network.make_workspace();
+        const Eigen::VectorXd input = Eigen::VectorXd::Random(inputs);
+        Eigen::VectorXd output(outputs);
+        suite.run("sequential.predict_into", {{"layers", depth}}, 1, flops, 0,
+                  [&] { network.predict_into(input, output, workspace); });
+
+        const RowMatrixXd batch = RowMatrixXd::Random(1024, inputs);
+        RowMatrixXd batch_output(1024, outputs);
+        suite.run("sequential.predict_batch", {{"layers", depth}, {"batch", 1024}}, 1024, flops * 1024, 0,
+                  [&] { network.predict_batch(batch, batch_output); });
+    }
+}
+
+// Each thread scores its own shard of rows with the shared, const model.
+void bench_threads(Suite& suite) {
+    const Eigen::Index inputs = 784, hidden = 128, outputs = 10, rows_per_thread = 1024;
+    const MLP model = make_mlp(inputs, hidden, outputs);
+    const int hardware = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+
+    std::vector<int> thread_counts = {1, 2, 4, hardware};
+    std::sort(thread_counts.begin(), thread_counts.end());
+    thread_counts.erase(std::unique(thread_counts.begin(), thread_counts.end()), thread_counts.end());
+
+    for (int threads : thread_counts) {
+        std::vector<RowMatrixXd> shards(threads, RowMatrixXd::Random(rows_per_thread, inputs));
+        std::vector<RowMatrixXd> results(threads, RowMatrixXd(rows_per_thread, outputs));
+        const double rows = double(rows_per_thread * threads);
+        ParallelRounds rounds(threads, [&](int t) { model.predict_batch(shards[t], results[t]); });
+        suite.run("mlp.predict_batch.mt", {{"threads", threads}, {"rows_per_thread", rows_per_thread}}, rows,
+                  mlp_flops(inputs, hidden, outputs) * rows, 0, [&] { rounds.run(); });
+    }
+}
+
+void bench_add_vectors(Suite& suite) {
+    for (std::size_t size : {16u, 1024u, 65536u, 1u << 20}) {
+        const std::vector<double> a(size, 1.5), b(size, 2.5);
+        std::vector<double> sum;
+        // Two loads and one store per element.
+        suite.run("add_vectors", {{"size", static_cast<long long>(size)}}, double(size), double(size),
+                  3.0 * sizeof(double) * double(size), [&] { sum = add_vectors(a, b); });
+    }
+}
+
+// Every math_lib kernel set the CPU supports, so SIMD speedups are measured
+// against the scalar fallback on the same machine.
+void bench_vector_kernels(Suite& suite) {
+    for (std::size_t size : {1024u, 65536u, 1u << 20}) {
+        std::vector<float> x(size, 1.25f), y(size, -0.5f), out(size);
+        const long long n = static_cast<long long>(size);
+        const double bytes = double(sizeof(float)) * double(size);
+
+        for (const std::string& kernel : math_lib::available_kernels()) {
+            math_lib::set_kernel(kernel);
+            const std::string prefix = "vec." + kernel + ".";
+            suite.run(prefix + "add", {{"size", n}}, double(size), double(size), 3 * bytes,
+                      [&] { math_lib::add(x.data(), y.data(), out.data(), size); });
+            suite.run(prefix + "axpy", {{"size", n}}, double(size), 2.0 * double(size), 3 * bytes,
+                      [&] { math_lib::axpy(1e-6f, x.data(), out.data(), size); });
+            suite.run(prefix + "dot", {{"size", n}}, double(size), 2.0 * double(size), 2 * bytes,
+                      [&] { benchmark_sink = math_lib::dot(x.data(), y.data(), size); });
+            // One pass for the whole chain, against three separate kernel calls.
+            suite.run(prefix + "standardize", {{"size", n}}, double(size), 2.0 * double(size), 2 * bytes,
+                      [&] { math_lib::evaluate(out.data(), (math_lib::vec(x) - 0.25f) * 4.0f); });
+        }
+        math_lib::set_kernel(math_lib::available_kernels().front());
+    }
+}
+
+// The cost of one instrumented stage. Without INFERENCE_PROFILING the scope
+// compiles to nothing and must match the empty baseline; comparing
+// mlp.predict_into between a default and a -DINFERENCE_PROFILING=ON build
+// shows the cost on a real forward pass.
+void bench_profiling(Suite& suite) {
+    MLP model = make_mlp(16, 16, 4);
+    static_cast<void>(model);
+    suite.run("profiling.baseline", {}, 1, 0, 0, [] {});
+    suite.run("profiling.scope", {}, 1, 0, 0, [&] { INFERENCE_PROFILE_SCOPE(model.profiler(), ProfileStage::Layer1); });
+}
+
+int parse_options(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--json" && i + 1 < argc) {
+            options.json_path = argv[++i];
+        } else if (arg == "--filter" && i + 1 < argc) {
+            options.filter = argv[++i];
+        } else if (arg == "--samples" && i + 1 < argc) {
+            options.samples = std::max(10ull, std::strtoull(argv[++i], nullptr, 10));
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--json PATH] [--filter SUBSTRING] [--samples N]\n";
+            return arg == "--help" || arg == "-h" ? 0 : 2;
+        }
+    }
+    return -1;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    const int status = parse_options(argc, argv, options);
+    if (status >= 0) {
+        return status;
+    }
+
+    const bool counters_available = PerfCounters().available();
+    std::cout << "int8 kernel: " << QuantizedMLP::kernel_name()
+              << ", perf counters: " << (counters_available ? "on" : "unavailable")
+              << ", allocation counting: " << (kCountsAllocations ? "on" : "unavailable")
+              << ", profiling: " << (kProfiling ? "on" : "off") << "\n\n";
+    print_header();
+
+    Suite suite(options);
+    bench_mlp_single(suite);
+    bench_mlp_batch(suite);
+    bench_sequential(suite);
+    bench_threads(suite);
+    bench_add_vectors(suite);
+    bench_vector_kernels(suite);
+    bench_profiling(suite);
+
+    if (!options.json_path.empty()) {
+        write_json(options.json_path, suite.results(), counters_available);
+        std::cout << "\nWrote " << options.json_path << "\n";
+    }
+
+    // The allocation-free paths are a contract, not just a number.
+    int exit_code = 0;
+    if (kCountsAllocations) {
+        for (const Result& r : suite.results()) {
+            if (r.name.find("predict_into") != std::string::npos && r.allocs_per_call > 0) {
+                std::cerr << "ERROR: " << r.name << " " << format_params(r) << " allocated "
+                          << r.allocs_per_call << " times per call.\n";
+                exit_code = 1;
+            }
+        }
+    }
+    return exit_code;
+}
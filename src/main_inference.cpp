@@ -1,29 +1,190 @@
+#include <exception>
+#include <fstream>
 #include <iostream>
-#include "inference_lib.h"
+#include <string>
+#include <vector>
+#include "batch_scoring.h"
+#include "model_file.h"
+
+// Usage:
+//   main_inference [MODEL]
+//       Runs one forward pass on a random input (a random 784-128-10 network
+//       when no model file is given).
+//   main_inference MODEL INPUT -o OUTPUT [options]
+//       Streams every row of INPUT through MODEL and writes one result per
+//       row, in order, to OUTPUT ("-" for stdout).
+//
+// Options:
+//   --format auto|idx|raw       input format (default auto)
+//   --cols N                    features per row of a raw input
+//   --dtype u8|i8|i16|i32|f32|f64  element type of a raw input (default f32)
+//   --scale S                   multiply every input value by S, e.g.
+//                               0.00392156862745098 for MNIST pixels
+//   --write labels|logits|csv   what to write per row (default labels)
+//   --threads N                 worker threads (default: all hardware threads)
+//   --chunk-rows N              rows per batch (default 4096)
+//   --in-flight N               chunks held in memory at once (default 2 x threads)
+namespace {
+
+struct CommandLine {
+    std::string model_path;
+    std::string input_path;
+    std::string output_path;
+    DatasetOptions dataset;
+    ScoringOptions scoring;
+};
+
+void print_usage(const char* program) {
+    std::cerr << "Usage: " << program << " [MODEL]\n"
+              << "       " << program << " MODEL INPUT -o OUTPUT [--format auto|idx|raw] [--cols N]\n"
+              << "           [--dtype u8|i8|i16|i32|f32|f64] [--scale S] [--write labels|logits|csv]\n"
+              << "           [--threads N] [--chunk-rows N] [--in-flight N]\n";
+}
+
+CommandLine parse_command_line(int argc, char** argv) {
+    CommandLine cmd;
+    std::vector<std::string> positional;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const auto value = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                throw std::invalid_argument("Missing value for " + arg + ".");
+            }
+            return argv[++i];
+        };
+        if (arg == "-o" || arg == "--output") {
+            cmd.output_path = value();
+        } else if (arg == "--format") {
+            const std::string format = value();
+            if (format == "auto") cmd.dataset.format = DatasetFormat::Auto;
+            else if (format == "idx") cmd.dataset.format = DatasetFormat::Idx;
+            else if (format == "raw") cmd.dataset.format = DatasetFormat::Raw;
+            else throw std::invalid_argument("Unknown input format '" + format + "'.");
+        } else if (arg == "--cols") {
+            cmd.dataset.raw_cols = std::stol(value());
+        } else if (arg == "--dtype") {
+            cmd.dataset.raw_dtype = parse_dataset_dtype(value());
+        } else if (arg == "--scale") {
+            cmd.dataset.scale = std::stod(value());
+        } else if (arg == "--write") {
+            cmd.scoring.output = parse_score_output(value());
+        } else if (arg == "--threads") {
+            cmd.scoring.threads = std::stoul(value());
+        } else if (arg == "--chunk-rows") {
+            cmd.scoring.chunk_rows = std::stol(value());
+        } else if (arg == "--in-flight") {
+            cmd.scoring.max_chunks_in_flight = std::stoul(value());
+        } else if (!arg.empty() && arg[0] == '-') {
+            throw std::invalid_argument("Unknown option " + arg + ".");
+        } else {
+            positional.push_back(arg);
+        }
+    }
+    if (positional.size() > 2) {
+        throw std::invalid_argument("Too many arguments.");
+    }
+    if (!positional.empty()) {
+        cmd.model_path = positional[0];
+    }
+    if (positional.size() == 2) {
+        cmd.input_path = positional[1];
+        if (cmd.output_path.empty()) {
+            throw std::invalid_argument("An output path (-o) is required when scoring a dataset.");
+        }
+    }
+    return cmd;
+}
+
+// Runs one forward pass of `network` on a random input and prints the logits.
+template <typename Scalar>
+int run(BasicSequential<Scalar> network) {
+    std::cout << "Execution plan:\n" << network.describe();
+
+    typename BasicSequential<Scalar>::Vector dummy_input =
+        BasicSequential<Scalar>::Vector::Random(network.input_size());
+
+    std::cout << "Running C++ forward pass with dummy data..." << std::endl;
+
+    // --- Call the forward pass ---
+    auto logits = network.predict(dummy_input);
+
+    std::cout << "Success! Output logits vector:" << std::endl;
+    std::cout << logits << std::endl;
+
+    return 0;
+}
+
+// Scores the whole dataset and reports throughput on stderr, so that the
+// results can go to stdout.
+template <typename Scalar>
+int score(const BasicSequential<Scalar>& network, const CommandLine& cmd) {
+    const MappedDataset data(cmd.input_path, cmd.dataset);
+    std::cerr << "Scoring " << data.rows() << " rows x " << data.cols() << " features from " << cmd.input_path
+              << (data.format() == DatasetFormat::Idx ? " (IDX)" : " (raw)") << std::endl;
+
+    std::ofstream file;
+    if (cmd.output_path != "-") {
+        file.open(cmd.output_path, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            throw std::runtime_error("Cannot open output file '" + cmd.output_path + "'.");
+        }
+    }
+    std::ostream& out = cmd.output_path == "-" ? std::cout : file;
+
+    const ScoringStats stats = score_dataset(network, data, out, cmd.scoring);
+    std::cerr << "Scored " << stats.rows << " rows in " << stats.chunks << " chunks on " << stats.threads
+              << " threads: " << stats.seconds << " s, " << static_cast<long long>(stats.rows_per_second())
+              << " rows/s" << std::endl;
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    CommandLine cmd;
+    try {
+        cmd = parse_command_line(argc, argv);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        print_usage(argv[0]);
+        return 2;
+    }
+
+    // --- Load a model file if one is given ---
+    // The weights are memory-mapped, not copied.
+    if (!cmd.model_path.empty()) {
+        try {
+            MappedModel model(cmd.model_path);
+            std::cerr << "Mapped " << cmd.model_path << " (" << model.size_bytes() << " bytes, "
+                      << model.layer_count() << " layers)" << std::endl;
+            if (!cmd.input_path.empty()) {
+                if (model.dtype() == ModelDType::Float32) {
+                    return score(model.network<float>(), cmd);
+                }
+                return score(model.network<double>(), cmd);
+            }
+            if (model.dtype() == ModelDType::Float32) {
+                return run(model.network<float>());
+            }
+            return run(model.network<double>());
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+            return 1;
+        }
+    }
 
-int main() {
     // --- Define network architecture ---
     const int INPUT_SIZE = 784;
     const int HIDDEN_SIZE = 128;
     const int OUTPUT_SIZE = 10;
 
-    // --- Create dummy data and weights ---
-    // In a real scenario, would load these from the file saved in Python.
-    Eigen::VectorXd dummy_input = Eigen::VectorXd::Random(INPUT_SIZE);
-    
+    // --- Create dummy weights ---
     Eigen::MatrixXd w1 = Eigen::MatrixXd::Random(INPUT_SIZE, HIDDEN_SIZE);
     Eigen::VectorXd b1 = Eigen::VectorXd::Random(HIDDEN_SIZE);
-    
+
     Eigen::MatrixXd w2 = Eigen::MatrixXd::Random(HIDDEN_SIZE, OUTPUT_SIZE);
     Eigen::VectorXd b2 = Eigen::VectorXd::Random(OUTPUT_SIZE);
-    
-    std::cout << "Running C++ forward pass with dummy data..." << std::endl;
-    
-    // --- Call the forward pass function ---
-    Eigen::VectorXd logits = forward_pass(dummy_input, w1, b1, w2, b2);
-    
-    std::cout << "Success! Output logits vector:" << std::endl;
-    std::cout << logits << std::endl;
-    
-    return 0;
-}
\ No newline at end of file
+
+    // --- Build the network: dense -> ReLU -> dense ---
+    return run(Sequential({Layer::dense(w1, b1), Layer::relu(), Layer::dense(w2, b2)}));
+}